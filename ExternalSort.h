@@ -0,0 +1,418 @@
+// Out-of-core sorting of binary record files
+// The comments begin with "#" follow the same convention as Sort.h
+
+
+#ifndef EXTERNAL_SORT_H
+#define EXTERNAL_SORT_H
+
+/**
+ * External sort for files larger than memory.
+ * A file is a sequence of fixed-size binary records (any trivially
+ * copyable type). It is sorted in three stages:
+ *  1. Chunks of the memory budget are read with large sequential reads and
+ *     sorted in memory with quicksort (Sort.h).
+ *  2. Each sorted chunk is spilled as a run to the temporary directory.
+ *  3. The runs are merged k at a time by a LoserTree (Sort.h); every
+ *     run is read through two buffers, one filled by a background read
+ *     while the other is merged, and the output is written the same way.
+ * When there are more runs than the budget has buffers for, the merge
+ * takes several passes through the temporary directory.
+ * I/O errors throw runtime_error; temporary files are always removed.
+ */
+
+#include "Sort.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+using namespace std;
+
+/**
+ * Smallest read or write buffer of the merge, in bytes.
+ */
+const size_t EXTERNAL_SORT_MIN_BLOCK = 1 << 12;
+
+/**
+ * Most runs merged at once (each one holds a file descriptor).
+ */
+const int EXTERNAL_SORT_MAX_FAN_IN = 512;
+
+/**
+ * Most records sorted in memory at once: quicksort indexes with int.
+ */
+const size_t EXTERNAL_SORT_MAX_CHUNK = INT_MAX;
+
+/**
+ * Records of recordSize bytes that externalSort sorts in memory at once
+ * with memoryBudget bytes.
+ */
+inline size_t externalSortChunkRecords( size_t memoryBudget, size_t recordSize )
+{
+    return min( memoryBudget / recordSize, EXTERNAL_SORT_MAX_CHUNK );
+}
+
+/**
+ * What an externalSort did.
+ */
+struct ExternalSortStats
+{
+    long long records = 0;     // Records sorted
+    int runs = 0;              // Sorted runs spilled by stage 2
+    int mergePasses = 0;       // Passes of the k-way merge (0 if one run)
+};
+
+/**
+ * Internal class for externalSort: a file descriptor that is closed
+ * when it goes out of scope. Reads and writes loop until all bytes
+ * are transferred.
+ */
+class RecordFile
+{
+  public:
+    RecordFile( const string & filePath, int flags ) : path( filePath )
+    {
+        fd = ::open( path.c_str( ), flags, 0644 );
+        if( fd < 0 )
+            fail( "cannot open" );
+#ifdef POSIX_FADV_SEQUENTIAL
+        posix_fadvise( fd, 0, 0, POSIX_FADV_SEQUENTIAL );
+#endif
+    }
+
+    ~RecordFile( )
+    {
+        if( fd >= 0 )
+            ::close( fd );
+    }
+
+    RecordFile( const RecordFile & ) = delete;
+    RecordFile & operator=( const RecordFile & ) = delete;
+
+    /**
+     * Reads up to bytes bytes; returns fewer only at the end of the file.
+     */
+    size_t read( void *buffer, size_t bytes )
+    {
+        size_t done = 0;
+        while( done < bytes )
+        {
+            ssize_t got = ::read( fd, static_cast<char *>( buffer ) + done, bytes - done );
+            if( got < 0 && errno == EINTR )
+                continue;
+            if( got < 0 )
+                fail( "cannot read" );
+            if( got == 0 )
+                break;
+            done += got;
+        }
+        return done;
+    }
+
+    void write( const void *buffer, size_t bytes )
+    {
+        size_t done = 0;
+        while( done < bytes )
+        {
+            ssize_t put = ::write( fd, static_cast<const char *>( buffer ) + done, bytes - done );
+            if( put < 0 && errno == EINTR )
+                continue;
+            if( put < 0 )
+                fail( "cannot write" );
+            done += put;
+        }
+    }
+
+    long long size( ) const
+    {
+        struct stat info;
+        if( fstat( fd, &info ) != 0 )
+            fail( "cannot stat" );
+        return info.st_size;
+    }
+
+  private:
+    string path;
+    int fd;
+
+    void fail( const char *what ) const
+    {
+        throw runtime_error( string( what ) + " " + path + ": " + strerror( errno ) );
+    }
+};
+
+/**
+ * Internal class for externalSort: reads a file of records sequentially
+ * through two buffers. While the caller consumes one buffer, the next
+ * block is read into the other one by a background task.
+ */
+template <typename Record>
+class RunReader
+{
+  public:
+    RunReader( const string & path, size_t blockRecords )
+      : file( path, O_RDONLY ), current( blockRecords ), next( blockRecords ), pos( 0 ), size( 0 )
+    {
+        size = readBlock( current );
+        if( size == current.size( ) )
+            prefetch( );
+    }
+
+    ~RunReader( )
+    {
+        if( pending.valid( ) )
+            pending.wait( );
+    }
+
+    bool empty( ) const
+      { return pos == size; }
+
+    const Record & front( ) const
+      { return current[ pos ]; }
+
+    /**
+     * Moves to the next record, switching buffers at the end of a block.
+     */
+    void pop( )
+    {
+        if( ++pos < size )
+            return;
+        pos = size = 0;
+        if( !pending.valid( ) )
+            return;      // The last block was short: end of file
+
+        size = pending.get( );
+        current.swap( next );
+        if( size == current.size( ) )
+            prefetch( );
+    }
+
+  private:
+    RecordFile file;
+    vector<Record> current;
+    vector<Record> next;
+    size_t pos;
+    size_t size;
+    future<size_t> pending;
+
+    size_t readBlock( vector<Record> & block )
+    {
+        return file.read( block.data( ), block.size( ) * sizeof( Record ) ) / sizeof( Record );
+    }
+
+    void prefetch( )
+    {
+        pending = async( launch::async, [ this ] { return readBlock( next ); } );
+    }
+};
+
+/**
+ * Internal class for externalSort: writes records sequentially through
+ * two buffers. A full buffer is written by a background task while the
+ * caller fills the other one.
+ */
+template <typename Record>
+class RunWriter
+{
+  public:
+    RunWriter( const string & path, size_t blockRecords )
+      : file( path, O_WRONLY | O_CREAT | O_TRUNC ), current( blockRecords ), next( blockRecords ), size( 0 ) { }
+
+    ~RunWriter( )
+    {
+        if( pending.valid( ) )
+            pending.wait( );
+    }
+
+    void push( const Record & x )
+    {
+        current[ size++ ] = x;
+        if( size == current.size( ) )
+            flushBlock( );
+    }
+
+    /**
+     * Writes everything pushed so far; must be called before destruction.
+     */
+    void close( )
+    {
+        flushBlock( );
+        if( pending.valid( ) )
+            pending.get( );
+    }
+
+  private:
+    RecordFile file;
+    vector<Record> current;
+    vector<Record> next;
+    size_t size;
+    future<void> pending;
+
+    void flushBlock( )
+    {
+        if( pending.valid( ) )
+            pending.get( );     // next is free again
+        if( size == 0 )
+            return;
+        current.swap( next );
+        size_t bytes = size * sizeof( Record );
+        size = 0;
+        pending = async( launch::async, [ this, bytes ] { file.write( next.data( ), bytes ); } );
+    }
+};
+
+/**
+ * Internal class for externalSort: names the temporary run files and
+ * removes the ones that are still there when it goes out of scope.
+ */
+class TempRuns
+{
+  public:
+    explicit TempRuns( const string & directory ) : dir( directory ), counter( 0 ) { }
+
+    ~TempRuns( )
+    {
+        for( const string & path : paths )
+            ::unlink( path.c_str( ) );
+    }
+
+    string create( )
+    {
+        static atomic<int> instances( 0 );
+        if( counter == 0 )
+            id = to_string( getpid( ) ) + "-" + to_string( instances++ );
+        paths.push_back( dir + "/extsort-" + id + "-" + to_string( counter++ ) + ".run" );
+        return paths.back( );
+    }
+
+    void remove( const string & path )
+    {
+        ::unlink( path.c_str( ) );
+        paths.erase( std::find( paths.begin( ), paths.end( ), path ) );
+    }
+
+  private:
+    string dir;
+    string id;
+    int counter;
+    vector<string> paths;
+};
+
+/**
+ * Internal method for externalSort (stage 3).
+ * Merges the sorted run files into one file at outputPath.
+ * blockRecords is the size of each of the two buffers of every reader
+ * and of the writer.
+ */
+template <typename Record, typename Comparator>
+void mergeRunFiles( const vector<string> & runs, const string & outputPath,
+                    Comparator compare, size_t blockRecords )
+{
+    vector<unique_ptr<RunReader<Record> > > readers;
+    vector<RunReader<Record> *> sources;
+    for( const string & run : runs )
+    {
+        readers.emplace_back( new RunReader<Record>( run, blockRecords ) );
+        sources.push_back( readers.back( ).get( ) );
+    }
+    RunWriter<Record> writer( outputPath, blockRecords );
+
+    for( LoserTree<RunReader<Record>, Comparator> tree( sources, compare ); !tree.empty( ); tree.pop( ) )
+        writer.push( tree.front( ) );
+    writer.close( );
+}
+
+/**
+ * #(This function is added)
+ * Sorts the binary file inputPath of Record items into outputPath,
+ * using about memoryBudget bytes of memory and temporary run files in
+ * tempDir. Record must be trivially copyable; the file size must be a
+ * multiple of sizeof( Record ). inputPath and outputPath may be the same.
+ * Chunks are sorted in memory up to EXTERNAL_SORT_MAX_CHUNK records, so
+ * larger budgets than that only widen the merges.
+ * Throws runtime_error on I/O errors or a budget too small for one record.
+ * # @compare: less_than or greater_than, able to sort smallest to largest
+ *				or largest to smallest
+ */
+template <typename Record, typename Comparator>
+ExternalSortStats externalSort( const string & inputPath, const string & outputPath,
+                                Comparator compare, size_t memoryBudget,
+                                const string & tempDir = "/tmp" )
+{
+    static_assert( is_trivially_copyable<Record>::value,
+                   "externalSort needs trivially copyable records" );
+
+    ExternalSortStats stats;
+    size_t chunkRecords = externalSortChunkRecords( memoryBudget, sizeof( Record ) );
+    if( chunkRecords == 0 )
+        throw runtime_error( "externalSort: memory budget is smaller than one record" );
+
+    TempRuns temp( tempDir );
+    vector<string> runs;
+    {
+        RecordFile input( inputPath, O_RDONLY );
+        if( input.size( ) % sizeof( Record ) != 0 )
+            throw runtime_error( "externalSort: " + inputPath + " is not a whole number of records" );
+        stats.records = input.size( ) / sizeof( Record );
+
+            // Stages 1 and 2: sort chunks of the budget and spill them as runs
+        vector<Record> chunk( min<long long>( chunkRecords, max( stats.records, 1LL ) ) );
+        bool oneChunk = stats.records <= (long long) chunk.size( );
+        for( ; ; )
+        {
+            size_t n = input.read( chunk.data( ), chunk.size( ) * sizeof( Record ) ) / sizeof( Record );
+            if( n == 0 && !oneChunk )
+                break;
+
+            quicksort( span<Record>( chunk.data( ), n ), compare );
+            ++stats.runs;
+            if( oneChunk )   // Everything was read: no runs, no merge
+            {
+                RecordFile output( outputPath, O_WRONLY | O_CREAT | O_TRUNC );
+                output.write( chunk.data( ), n * sizeof( Record ) );
+                return stats;
+            }
+            runs.push_back( temp.create( ) );
+            RecordFile run( runs.back( ), O_WRONLY | O_CREAT | O_TRUNC );
+            run.write( chunk.data( ), n * sizeof( Record ) );
+        }
+    }
+
+        // Stage 3: k-way merges; each run and the output get two blocks
+    long long budgetBlocks = memoryBudget / max( EXTERNAL_SORT_MIN_BLOCK, sizeof( Record ) );
+    int fanIn = max<long long>( 2, min<long long>( budgetBlocks / 2 - 1, EXTERNAL_SORT_MAX_FAN_IN ) );
+    while( runs.size( ) > 1 )
+    {
+        ++stats.mergePasses;
+        bool lastPass = (int) runs.size( ) <= fanIn;
+        vector<string> merged;
+        for( size_t first = 0; first < runs.size( ); first += fanIn )
+        {
+            vector<string> group( runs.begin( ) + first,
+                                  runs.begin( ) + min( runs.size( ), first + fanIn ) );
+            if( group.size( ) == 1 )
+            {
+                merged.push_back( group[ 0 ] );   // Nothing to merge it with this pass
+                continue;
+            }
+            size_t blockRecords = max<size_t>( 1, memoryBudget / ( 2 * ( group.size( ) + 1 ) ) / sizeof( Record ) );
+            merged.push_back( lastPass ? outputPath : temp.create( ) );
+            mergeRunFiles<Record>( group, merged.back( ), compare, blockRecords );
+            for( const string & run : group )
+                temp.remove( run );
+        }
+        runs = merged;
+    }
+    return stats;
+}
+
+#endif
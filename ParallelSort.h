@@ -0,0 +1,479 @@
+// Multi-threaded versions of the routines in Sort.h
+// The comments begin with "#" follow the same convention as Sort.h
+
+
+#ifndef PARALLEL_SORT_H
+#define PARALLEL_SORT_H
+
+/**
+ * Parallel sorting routines.
+ * Large subarrays are handed to a work-stealing task pool,
+ * small ones fall back to the serial routines of Sort.h.
+ * Arrays are rearranged with smallest item first.
+ */
+
+#include "Sort.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+/**
+ * Subarrays with at most this many items are sorted serially.
+ */
+const int PARALLEL_SORT_GRAIN = 1 << 14;
+
+/**
+ * Number of threads used when the caller does not ask for a count.
+ */
+inline int defaultThreadCount( )
+{
+    int n = thread::hardware_concurrency( );
+    return n > 0 ? n : 1;
+}
+
+/**
+ * Counts the tasks of one fork/join region that are not finished yet.
+ */
+class TaskGroup
+{
+  public:
+    TaskGroup( ) : pending( 0 ) { }
+
+    bool done( ) const
+      { return pending.load( memory_order_acquire ) == 0; }
+
+  private:
+    atomic<int> pending;
+
+    friend class TaskPool;
+};
+
+/**
+ * Work-stealing task pool.
+ * Every thread owns a deque. It pushes and pops its own tasks at the back
+ * (newest first, the data is still in cache) and steals from the front of
+ * the other deques (oldest first, those are the largest subarrays).
+ * The thread that calls wait( ) runs tasks too, so a pool of numThreads
+ * starts numThreads - 1 workers.
+ */
+class TaskPool
+{
+  public:
+    explicit TaskPool( int numThreads )
+      : queues( max( numThreads, 1 ) ), stopping( false )
+    {
+        for( int i = 1; i < (int) queues.size( ); ++i )
+            workers.push_back( thread( [ this, i ] { workerLoop( i ); } ) );
+    }
+
+    ~TaskPool( )
+    {
+        stopping.store( true );
+        for( auto & w : workers )
+            w.join( );
+    }
+
+    TaskPool( const TaskPool & ) = delete;
+    TaskPool & operator=( const TaskPool & ) = delete;
+
+    int size( ) const
+      { return queues.size( ); }
+
+    /**
+     * Schedule task as part of group.
+     * The task goes to the deque of the calling thread.
+     */
+    void submit( TaskGroup & group, function<void( )> task )
+    {
+        group.pending.fetch_add( 1, memory_order_relaxed );
+        WorkQueue & q = queues[ myQueue( ) ];
+        lock_guard<mutex> guard( q.lock );
+        q.tasks.push_back( Task{ std::move( task ), &group } );
+    }
+
+    /**
+     * Run tasks until every task of group (and every task they
+     * submitted) has finished.
+     */
+    void wait( TaskGroup & group )
+    {
+        int self = myQueue( );
+        while( !group.done( ) )
+            if( !runOne( self ) )
+                this_thread::yield( );
+    }
+
+  private:
+    struct Task
+    {
+        function<void( )> run;
+        TaskGroup *group;
+    };
+
+    struct WorkQueue
+    {
+        mutex lock;
+        deque<Task> tasks;
+    };
+
+    vector<WorkQueue> queues;
+    vector<thread> workers;
+    atomic<bool> stopping;
+
+    /**
+     * Index of the deque owned by the calling thread.
+     * Threads that do not belong to this pool share deque 0.
+     */
+    int myQueue( ) const
+    {
+        return currentPool( ) == this ? currentIndex( ) : 0;
+    }
+
+    static const TaskPool * & currentPool( )
+    {
+        static thread_local const TaskPool *pool = nullptr;
+        return pool;
+    }
+
+    static int & currentIndex( )
+    {
+        static thread_local int index = 0;
+        return index;
+    }
+
+    void workerLoop( int self )
+    {
+        currentPool( ) = this;
+        currentIndex( ) = self;
+
+        int idle = 0;
+        while( !stopping.load( ) )
+        {
+            if( runOne( self ) )
+                idle = 0;
+            else if( ++idle < 64 )
+                this_thread::yield( );
+            else
+                this_thread::sleep_for( chrono::microseconds( 50 ) );
+        }
+    }
+
+    /**
+     * Pop a task from our own deque, or steal one from another deque,
+     * and run it. Returns false if no work was found.
+     */
+    bool runOne( int self )
+    {
+        Task task;
+        if( !popBack( self, task ) )
+        {
+            int n = queues.size( );
+            bool found = false;
+            for( int k = 1; k < n && !found; ++k )
+                found = popFront( ( self + k ) % n, task );
+            if( !found )
+                return false;
+        }
+        task.run( );
+        task.group->pending.fetch_sub( 1, memory_order_release );
+        return true;
+    }
+
+    bool popBack( int q, Task & task )
+    {
+        lock_guard<mutex> guard( queues[ q ].lock );
+        if( queues[ q ].tasks.empty( ) )
+            return false;
+        task = std::move( queues[ q ].tasks.back( ) );
+        queues[ q ].tasks.pop_back( );
+        return true;
+    }
+
+    bool popFront( int q, Task & task )
+    {
+        lock_guard<mutex> guard( queues[ q ].lock );
+        if( queues[ q ].tasks.empty( ) )
+            return false;
+        task = std::move( queues[ q ].tasks.front( ) );
+        queues[ q ].tasks.pop_front( );
+        return true;
+    }
+};
+
+/**
+ * Internal parallel quicksort method.
+ * Takes the same introsort steps as quicksort (median-of-three pivot,
+ * Hoare partition, heapsort after too many unbalanced partitions), hands
+ * the smaller side of each partition to the pool and keeps partitioning
+ * the larger side until it is no larger than grain, then finishes it
+ * serially with introsort.
+ * a is an array of Comparable items.
+ * left is the left-most index of the subarray.
+ * right is the right-most index of the subarray.
+ * badAllowed, leftmost and cutoff are as in introsort.
+ * # @compare: less_than or greater_than, able to sort smallest to largest
+ *				or largest to smallest
+ */
+template <typename RandomIt, typename Comparator>
+void parallelQuicksort( RandomIt a, int left, int right, Comparator compare,
+                        int badAllowed, bool leftmost, int cutoff,
+                        TaskPool & pool, TaskGroup & group, int grain )
+{
+    while( right - left + 1 > grain )
+    {
+        int pivotPos = introsortStep<MedianOfThreePivot, HoarePartition>( a, left, right, compare,
+                                                                         badAllowed, leftmost );
+        if( pivotPos < 0 )
+            return;
+
+        if( pivotPos - left < right - pivotPos )
+        {
+            int subRight = pivotPos - 1;
+            pool.submit( group, [ a, left, subRight, compare, badAllowed, leftmost, cutoff, &pool, &group, grain ]
+                { parallelQuicksort( a, left, subRight, compare, badAllowed, leftmost, cutoff, pool, group, grain ); } );
+            left = pivotPos + 1;
+            leftmost = false;
+        }
+        else
+        {
+            int subLeft = pivotPos + 1;
+            pool.submit( group, [ a, subLeft, right, compare, badAllowed, cutoff, &pool, &group, grain ]
+                { parallelQuicksort( a, subLeft, right, compare, badAllowed, false, cutoff, pool, group, grain ); } );
+            right = pivotPos - 1;
+        }
+    }
+    if( left < right )
+        introsort<MedianOfThreePivot, HoarePartition>( a, left, right, compare, badAllowed, leftmost, cutoff );
+}
+
+/**
+ * #(This function is added)
+ * Parallel quicksort algorithm (driver).
+ * Takes the same introsort steps as quicksort( a, compare ), with the
+ * sides of each partition sorted in parallel, so it produces the same
+ * ordering for the items quicksort sorts directly (not IndirectSort).
+ * Sorts the items in [ first, last ); the vector and span versions sort
+ * all their items.
+ * numThreads is the number of threads, including the caller.
+ * grain is the largest subarray that is sorted serially.
+ * # @compare: less_than or greater_than, able to sort smallest to largest
+ *				or largest to smallest
+ */
+template <typename RandomIt, typename Comparator>
+void parallelQuicksort( RandomIt first, RandomIt last, Comparator compare,
+                        int numThreads = defaultThreadCount( ),
+                        int grain = PARALLEL_SORT_GRAIN )
+{
+    int n = checkedSize( first, last );
+    if( numThreads <= 1 || n <= grain )
+    {
+        quicksort( first, last, compare );
+        return;
+    }
+
+    TaskPool pool( numThreads );
+    TaskGroup group;
+    auto a = arrayBegin( first );
+    parallelQuicksort( a, 0, n - 1, compare, log2Floor( n ) + 1, true,
+                       SortLeaf<decltype( a ), Comparator>::cutoff( n ), pool, group, max( grain, 16 ) );
+    pool.wait( group );
+}
+
+template <typename Comparable, typename Comparator>
+void parallelQuicksort( vector<Comparable> & a, Comparator compare,
+                        int numThreads = defaultThreadCount( ),
+                        int grain = PARALLEL_SORT_GRAIN )
+{
+    parallelQuicksort( a.begin( ), a.end( ), compare, numThreads, grain );
+}
+
+template <typename Comparable, typename Comparator>
+void parallelQuicksort( span<Comparable> a, Comparator compare,
+                        int numThreads = defaultThreadCount( ),
+                        int grain = PARALLEL_SORT_GRAIN )
+{
+    parallelQuicksort( a.begin( ), a.end( ), compare, numThreads, grain );
+}
+
+/**
+ * Internal method for parallelMerge (merge-path co-ranking).
+ * The sorted runs a[ leftPos .. rightPos - 1 ] and a[ rightPos .. rightEnd ]
+ * are merged stably (ties are taken from the left run).
+ * Returns how many of the first diag merged items come from the left run.
+ */
+template <typename RandomIt, typename Comparator>
+int coRank( RandomIt a, int leftPos, int rightPos, int rightEnd,
+            int diag, Comparator compare )
+{
+    int leftSize = rightPos - leftPos;
+    int rightSize = rightEnd - rightPos + 1;
+    int low = max( 0, diag - rightSize );
+    int high = min( diag, leftSize );
+
+    while( low < high )
+    {
+        int i = low + ( high - low ) / 2;
+        int j = diag - i;
+            // a[ leftPos + i ] must come before a[ rightPos + j - 1 ]: take more of the left run
+        if( j > 0 && !compare( a[ rightPos + j - 1 ], a[ leftPos + i ] ) )
+            low = i + 1;
+        else
+            high = i;
+    }
+    return low;
+}
+
+/**
+ * Internal method for parallelMerge.
+ * Stably merges a[ leftPos .. leftEnd ] and a[ rightPos .. rightEnd ]
+ * into tmpArray starting at tmpPos.
+ */
+template <typename RandomIt, typename TmpIt, typename Comparator>
+void mergeInto( RandomIt a, TmpIt tmpArray,
+                int leftPos, int leftEnd, int rightPos, int rightEnd, int tmpPos,
+                Comparator compare )
+{
+    while( leftPos <= leftEnd && rightPos <= rightEnd )
+        if( compare( a[ rightPos ], a[ leftPos ] ) )
+            tmpArray[ tmpPos++ ] = std::move( a[ rightPos++ ] );
+        else
+            tmpArray[ tmpPos++ ] = std::move( a[ leftPos++ ] );
+
+    while( leftPos <= leftEnd )    // Copy rest of first half
+        tmpArray[ tmpPos++ ] = std::move( a[ leftPos++ ] );
+
+    while( rightPos <= rightEnd )  // Copy rest of right half
+        tmpArray[ tmpPos++ ] = std::move( a[ rightPos++ ] );
+}
+
+/**
+ * Internal method that merges two sorted halves of a subarray in parallel.
+ * The output is cut into pieces of about grain items; co-ranking finds
+ * where every piece starts in both halves, so the pieces are merged into
+ * tmpArray independently and then copied back in parallel.
+ * leftPos is the left-most index of the subarray.
+ * rightPos is the index of the start of the second half.
+ * rightEnd is the right-most index of the subarray.
+ */
+template <typename RandomIt, typename TmpIt, typename Comparator>
+void parallelMerge( RandomIt a, TmpIt tmpArray,
+                    int leftPos, int rightPos, int rightEnd, Comparator compare,
+                    TaskPool & pool, int grain )
+{
+    int numElements = rightEnd - leftPos + 1;
+    int pieces = min( numElements / grain, 4 * pool.size( ) );
+    if( pieces <= 1 )
+    {
+        ::merge( a, tmpArray, leftPos, rightPos, rightEnd, compare );
+        return;
+    }
+
+    TaskGroup merges;
+    for( int p = 0; p < pieces; ++p )
+    {
+        int diagBegin = (long long) numElements * p / pieces;
+        int diagEnd = (long long) numElements * ( p + 1 ) / pieces;
+        pool.submit( merges, [ a, tmpArray, leftPos, rightPos, rightEnd, diagBegin, diagEnd, compare ]
+        {
+            int iBegin = coRank( a, leftPos, rightPos, rightEnd, diagBegin, compare );
+            int iEnd = coRank( a, leftPos, rightPos, rightEnd, diagEnd, compare );
+            mergeInto( a, tmpArray,
+                       leftPos + iBegin, leftPos + iEnd - 1,
+                       rightPos + diagBegin - iBegin, rightPos + diagEnd - iEnd - 1,
+                       leftPos + diagBegin, compare );
+        } );
+    }
+    pool.wait( merges );
+
+        // Copy tmpArray back
+    TaskGroup copies;
+    for( int p = 0; p < pieces; ++p )
+    {
+        int first = leftPos + (long long) numElements * p / pieces;
+        int last = leftPos + (long long) numElements * ( p + 1 ) / pieces;
+        pool.submit( copies, [ a, tmpArray, first, last ]
+            { std::move( tmpArray + first, tmpArray + last, a + first ); } );
+    }
+    pool.wait( copies );
+}
+
+/**
+ * Internal parallel mergesort method.
+ * Both halves are sorted concurrently; subarrays of at most grain items
+ * use the serial mergeSort. All levels share one tmpArray.
+ * left is the left-most index of the subarray.
+ * right is the right-most index of the subarray.
+ */
+template <typename RandomIt, typename TmpIt, typename Comparator>
+void parallelMergeSort( RandomIt a, TmpIt tmpArray,
+                        int left, int right, Comparator compare,
+                        TaskPool & pool, int grain )
+{
+    if( right - left + 1 <= grain )
+    {
+        mergeSort( a, tmpArray, left, right, compare );
+        return;
+    }
+
+    int center = ( left + right ) / 2;
+    TaskGroup halves;
+    pool.submit( halves, [ a, tmpArray, left, center, compare, &pool, grain ]
+        { parallelMergeSort( a, tmpArray, left, center, compare, pool, grain ); } );
+    parallelMergeSort( a, tmpArray, center + 1, right, compare, pool, grain );
+    pool.wait( halves );
+    parallelMerge( a, tmpArray, left, center + 1, right, compare, pool, grain );
+}
+
+/**
+ * #(This function is added)
+ * Parallel mergesort algorithm (driver).
+ * Stable, and produces the same ordering as mergeSort( a, compare ).
+ * Sorts the items in [ first, last ); the vector and span versions sort
+ * all their items.
+ * numThreads is the number of threads, including the caller.
+ * grain is the largest subarray that is sorted or merged serially.
+ * # @compare: less_than or greater_than, able to sort smallest to largest
+ *				or largest to smallest
+ */
+template <typename RandomIt, typename Comparator>
+void parallelMergeSort( RandomIt first, RandomIt last, Comparator compare,
+                        int numThreads = defaultThreadCount( ),
+                        int grain = PARALLEL_SORT_GRAIN )
+{
+    typedef typename iterator_traits<RandomIt>::value_type Comparable;
+
+    int n = checkedSize( first, last );
+    if( numThreads <= 1 || n <= grain )
+    {
+        mergeSort( first, last, compare );
+        return;
+    }
+
+    vector<Comparable> tmpArray( n );
+    TaskPool pool( numThreads );
+    parallelMergeSort( arrayBegin( first ), tmpArray.data( ), 0, n - 1, compare, pool, max( grain, 2 ) );
+}
+
+template <typename Comparable, typename Comparator>
+void parallelMergeSort( vector<Comparable> & a, Comparator compare,
+                        int numThreads = defaultThreadCount( ),
+                        int grain = PARALLEL_SORT_GRAIN )
+{
+    parallelMergeSort( a.begin( ), a.end( ), compare, numThreads, grain );
+}
+
+template <typename Comparable, typename Comparator>
+void parallelMergeSort( span<Comparable> a, Comparator compare,
+                        int numThreads = defaultThreadCount( ),
+                        int grain = PARALLEL_SORT_GRAIN )
+{
+    parallelMergeSort( a.begin( ), a.end( ), compare, numThreads, grain );
+}
+
+#endif
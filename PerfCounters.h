@@ -0,0 +1,200 @@
+// Hardware performance counters for timing the routines in Sort.h
+
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+/**
+ * Hardware performance counters of the calling thread (Linux
+ * perf_event_open): cycles, instructions, branch misses, L1D, LLC and
+ * dTLB misses, counted in user space between start( ) and stop( ).
+ * Each counter is opened on its own, so the ones the CPU or the kernel
+ * does not provide (virtual machines, containers, perf_event_paranoid)
+ * are just missing; when none opens, available( ) is false and the
+ * callers time without counters. Other systems never have counters.
+ * Counters multiplexed by the kernel are scaled to the whole interval.
+ */
+
+#include <cstdint>
+#include <cstring>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+/**
+ * The counted events.
+ */
+enum PerfEvent
+{
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_BRANCH_MISSES,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_DTLB_MISSES,
+    PERF_EVENT_COUNT
+};
+
+inline const char *perfEventName( int event )
+{
+    static const char *names[ PERF_EVENT_COUNT ] =
+        { "Cycles", "Instructions", "Branch misses", "L1D misses", "LLC misses", "dTLB misses" };
+    return names[ event ];
+}
+
+/**
+ * What the counters counted between start( ) and stop( ).
+ * counted[ e ] is false for the events that could not be counted.
+ */
+struct PerfCounts
+{
+    bool counted[ PERF_EVENT_COUNT ] = { };
+    long long value[ PERF_EVENT_COUNT ] = { };
+
+    bool any( ) const
+    {
+        for( bool c : counted )
+            if( c )
+                return true;
+        return false;
+    }
+
+    /**
+     * Instructions per cycle, 0 if either was not counted.
+     */
+    double ipc( ) const
+    {
+        if( !counted[ PERF_CYCLES ] || !counted[ PERF_INSTRUCTIONS ] || value[ PERF_CYCLES ] == 0 )
+            return 0;
+        return double( value[ PERF_INSTRUCTIONS ] ) / value[ PERF_CYCLES ];
+    }
+};
+
+class PerfCounters
+{
+  public:
+    /**
+     * Opens the counters for the calling thread (stopped).
+     */
+    PerfCounters( )
+    {
+        for( int e = 0; e < PERF_EVENT_COUNT; ++e )
+            fds[ e ] = open( e );
+    }
+
+    ~PerfCounters( )
+    {
+#ifdef __linux__
+        for( int fd : fds )
+            if( fd >= 0 )
+                ::close( fd );
+#endif
+    }
+
+    PerfCounters( const PerfCounters & ) = delete;
+    PerfCounters & operator=( const PerfCounters & ) = delete;
+
+    bool available( ) const
+    {
+        for( int fd : fds )
+            if( fd >= 0 )
+                return true;
+        return false;
+    }
+
+    /**
+     * Resets the counters and starts counting.
+     */
+    void start( )
+    {
+#ifdef __linux__
+        for( int fd : fds )
+            if( fd >= 0 )
+                ioctl( fd, PERF_EVENT_IOC_RESET, 0 );
+        for( int fd : fds )
+            if( fd >= 0 )
+                ioctl( fd, PERF_EVENT_IOC_ENABLE, 0 );
+#endif
+    }
+
+    /**
+     * Stops counting and returns the counts since start( ).
+     */
+    PerfCounts stop( )
+    {
+        PerfCounts counts;
+#ifdef __linux__
+        for( int fd : fds )
+            if( fd >= 0 )
+                ioctl( fd, PERF_EVENT_IOC_DISABLE, 0 );
+        for( int e = 0; e < PERF_EVENT_COUNT; ++e )
+        {
+            uint64_t data[ 3 ];  // value, time enabled, time running
+            if( fds[ e ] < 0 || ::read( fds[ e ], data, sizeof( data ) ) != sizeof( data ) || data[ 2 ] == 0 )
+                continue;        // Not opened, or never scheduled on the PMU
+            counts.counted[ e ] = true;
+            counts.value[ e ] = data[ 2 ] < data[ 1 ] ? (long long) ( double( data[ 0 ] ) * data[ 1 ] / data[ 2 ] )
+                                                      : (long long) data[ 0 ];
+        }
+#endif
+        return counts;
+    }
+
+  private:
+    int fds[ PERF_EVENT_COUNT ];
+
+    /**
+     * Opens the counter of event, or returns -1.
+     */
+    static int open( int event )
+    {
+#ifdef __linux__
+        perf_event_attr attr;
+        memset( &attr, 0, sizeof( attr ) );
+        attr.size = sizeof( attr );
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        const uint64_t readMiss = ( PERF_COUNT_HW_CACHE_OP_READ << 8 ) | ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 );
+        switch( event )
+        {
+          case PERF_CYCLES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+          case PERF_INSTRUCTIONS:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+          case PERF_BRANCH_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+          case PERF_L1D_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D | readMiss;
+            break;
+          case PERF_LLC_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_LL | readMiss;
+            break;
+          case PERF_DTLB_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_DTLB | readMiss;
+            break;
+        }
+        return (int) syscall( SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC );
+#else
+        (void) event;
+        return -1;
+#endif
+    }
+};
+
+#endif
@@ -12,8 +12,365 @@
 
 #include <vector>
 #include <functional>
+#include <type_traits>
+#include <algorithm>
+#include <utility>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <cmath>
+#include <cstdint>
+#include <tuple>
+#include <climits>
+#include <limits>
+#include <stdexcept>
+#include "SortingNetworks.h"
+#include "SortTuning.h"
+#include "StringSort.h"
 using namespace std;
 
+/**
+ * #(This function is added)
+ * Internal method for the iterator versions of the algorithms.
+ * Every algorithm works on a random access iterator a, indexed like an
+ * array ( a[ i ] ). Contiguous iterators (vector, array, span, raw
+ * pointers) are turned into raw pointers, so all of them share the code
+ * generated for pointers; other iterators (deque) are used as they are.
+ */
+template <typename RandomIt>
+auto arrayBegin( RandomIt first )
+{
+    if constexpr( contiguous_iterator<RandomIt> )
+        return to_address( first );
+    else
+        return first;
+}
+
+/**
+ * #(This function is added)
+ * Internal method for the iterator versions of the algorithms that index
+ * with int: the number of items in [ first, last ).
+ * Throws length_error if there are more than INT_MAX, rather than letting
+ * the count wrap.
+ */
+template <typename RandomIt>
+int checkedSize( RandomIt first, RandomIt last )
+{
+    if( last - first > INT_MAX )
+        throw length_error( "sort: more than INT_MAX items" );
+    return int( last - first );
+}
+
+/**
+ * Internal class for the argsort methods and the indirect sorts:
+ * compares two indexes by the items of a they point to.
+ */
+template <typename RandomIt, typename Comparator>
+struct IndirectCompare
+{
+    RandomIt a;
+    Comparator compare;
+
+    template <typename Index>
+    bool operator()( Index x, Index y ) const
+    {
+        return compare( a[ x ], a[ y ] );
+    }
+};
+
+/**
+ * Internal method for the argsort methods and the indirect sorts:
+ * the identity permutation 0 .. n - 1.
+ * Throws length_error if Index cannot number n items.
+ */
+template <typename Index>
+vector<Index> identityPermutation( size_t n )
+{
+    static_assert( is_integral<Index>::value && is_unsigned<Index>::value,
+                   "argsort indexes must be unsigned integers" );
+    if( n > 0 && n - 1 > numeric_limits<Index>::max( ) )
+        throw length_error( "argsort: more items than the index type can number" );
+    vector<Index> perm( n );
+    for( size_t i = 0; i < n; ++i )
+        perm[ i ] = Index( i );
+    return perm;
+}
+
+/**
+ * #(This function is added)
+ * Reorders every column in place by the permutation perm of an argsort:
+ * afterwards column[ i ] holds the item that was at column[ perm[ i ] ].
+ * Any number of columns (vectors, spans, deques ... of the same size as
+ * perm, of any item types) are reordered together by following each cycle
+ * of perm once (cycle-leader): one item per column is held aside per
+ * cycle, and the only extra memory is one bit per item.
+ */
+template <typename Index, typename... Columns>
+void applyPermutation( const vector<Index> & perm, Columns &&... columns )
+{
+    size_t n = perm.size( );
+    vector<bool> placed( n, false );
+    for( size_t leader = 0; leader < n; ++leader )
+    {
+        if( placed[ leader ] || perm[ leader ] == leader )
+            continue;
+
+        auto held = make_tuple( std::move( columns[ leader ] )... );
+        size_t i = leader;
+        for( size_t next = perm[ i ]; next != leader; i = next, next = perm[ i ] )
+        {
+            ( ( columns[ i ] = std::move( columns[ next ] ) ), ... );
+            placed[ i ] = true;
+        }
+        apply( [ & ]( auto &... item ) { ( ( columns[ i ] = std::move( item ) ), ... ); }, held );
+        placed[ i ] = true;
+    }
+}
+
+/**
+ * Items larger than these many bytes are sorted indirectly by quicksort
+ * and by mergeSort. Mergesort moves every item at every level, so the
+ * indirect sort pays off for much smaller items than with quicksort,
+ * which only swaps misplaced items.
+ */
+const size_t INDIRECT_QUICKSORT_MIN_SIZE = 256;
+const size_t INDIRECT_MERGE_SORT_MIN_SIZE = 64;
+
+/**
+ * #(This trait is added)
+ * Whether quicksort and mergeSort sort Comparable items indirectly: they
+ * sort an array of 32-bit indexes instead, then move every item once,
+ * straight to its final position (applyPermutation), rather than swapping
+ * and copying the items themselves O( n log n ) times.
+ * Chosen for items larger than the sizes above and for items without a
+ * noexcept move (moving them may copy them). Specialize it to choose for
+ * a type.
+ */
+template <typename Comparable>
+struct IndirectSort
+{
+    static const bool expensiveMove = !is_nothrow_move_constructible<Comparable>::value
+                                      || !is_nothrow_move_assignable<Comparable>::value;
+    static const bool quicksort = expensiveMove || sizeof( Comparable ) > INDIRECT_QUICKSORT_MIN_SIZE;
+    static const bool mergeSort = expensiveMove || sizeof( Comparable ) > INDIRECT_MERGE_SORT_MIN_SIZE;
+};
+
+/**
+ * #(The instrumentation is added)
+ * Opt-in instrumentation of the algorithms.
+ * Sorting with the comparator instrument( compare, stats ) counts into
+ * stats the comparator calls, the swaps of items, the deepest recursion
+ * and the balance of every quicksort and selection partition; Tracked
+ * items also count their moves. With any other comparator the hooks
+ * below are empty and compile to nothing.
+ * Not synchronized: instrument sequential sorts only.
+ */
+
+/**
+ * Partition balance buckets: bucket b counts the partitions whose smaller
+ * side holds b * 10% to ( b + 1 ) * 10% of the items (the last one 40-50%).
+ */
+const int PARTITION_BALANCE_BUCKETS = 5;
+
+/**
+ * What an instrumented sort did.
+ */
+struct SortStats
+{
+    long long comparisons = 0;   // Comparator calls
+    long long moves = 0;         // Moves and copies of Tracked items (a swap is 3)
+    long long swaps = 0;         // Swaps of two items
+    int depth = 0;               // Current recursion depth
+    int maxDepth = 0;            // Deepest nesting of recursive calls
+    long long partitionBalance[ PARTITION_BALANCE_BUCKETS ] = { };
+};
+
+/**
+ * Comparator policy that counts its calls into stats.
+ */
+template <typename Comparator>
+struct Instrumented
+{
+    Comparator compare;
+    SortStats *stats;
+
+    template <typename T, typename U>
+    bool operator()( const T & x, const U & y ) const
+    {
+        ++stats->comparisons;
+        return compare( x, y );
+    }
+};
+
+template <typename Comparator>
+Instrumented<Comparator> instrument( Comparator compare, SortStats & stats )
+{
+    return Instrumented<Comparator>{ compare, &stats };
+}
+
+template <typename Comparator>
+struct IsInstrumented : false_type { };
+
+template <typename Comparator>
+struct IsInstrumented< Instrumented<Comparator> > : true_type { };
+
+/**
+ * Internal method for the algorithms: swaps two items (counted).
+ */
+template <typename T, typename Comparator>
+inline void swapItems( T & x, T & y, const Comparator & compare )
+{
+    if constexpr( IsInstrumented<Comparator>::value )
+        ++compare.stats->swaps;
+    std::swap( x, y );
+}
+
+/**
+ * Internal method for the partitioning algorithms: records the sizes of
+ * the two sides of a partition.
+ */
+template <typename Comparator>
+inline void recordPartition( const Comparator & compare, int leftSize, int rightSize )
+{
+    if constexpr( IsInstrumented<Comparator>::value )
+    {
+        int total = leftSize + rightSize;
+        if( total > 0 )
+        {
+            int bucket = min( leftSize, rightSize ) * 2 * PARTITION_BALANCE_BUCKETS / total;
+            ++compare.stats->partitionBalance[ min( bucket, PARTITION_BALANCE_BUCKETS - 1 ) ];
+        }
+    }
+}
+
+/**
+ * Internal class for the recursive algorithms: one level of recursion
+ * while it exists (counted).
+ */
+template <typename Comparator>
+struct RecursionLevel
+{
+    explicit RecursionLevel( const Comparator & ) { }
+};
+
+template <typename Comparator>
+struct RecursionLevel< Instrumented<Comparator> >
+{
+    SortStats *stats;
+
+    explicit RecursionLevel( const Instrumented<Comparator> & compare ) : stats( compare.stats )
+    {
+        stats->maxDepth = max( stats->maxDepth, ++stats->depth );
+    }
+
+    ~RecursionLevel( )
+      { --stats->depth; }
+};
+
+/**
+ * Counts the moves and copies of Tracked items made by this thread into
+ * stats while it exists.
+ */
+class TrackMoves
+{
+  public:
+    explicit TrackMoves( SortStats & stats ) : previous( current( ) )
+      { current( ) = &stats; }
+
+    ~TrackMoves( )
+      { current( ) = previous; }
+
+    static SortStats *& current( )
+    {
+        static thread_local SortStats *stats = nullptr;
+        return stats;
+    }
+
+  private:
+    SortStats *previous;
+};
+
+/**
+ * An item that counts its moves and copies (see TrackMoves). It converts
+ * to const T &, so the comparators of T compare Tracked<T> items.
+ */
+template <typename T>
+class Tracked
+{
+  public:
+    Tracked( ) = default;
+    Tracked( const T & x ) : value( x ) { }
+
+    Tracked( const Tracked & other ) : value( other.value )
+      { count( ); }
+
+    Tracked( Tracked && other ) noexcept : value( std::move( other.value ) )
+      { count( ); }
+
+    Tracked & operator=( const Tracked & other )
+    {
+        value = other.value;
+        count( );
+        return *this;
+    }
+
+    Tracked & operator=( Tracked && other ) noexcept
+    {
+        value = std::move( other.value );
+        count( );
+        return *this;
+    }
+
+    operator const T & ( ) const
+      { return value; }
+
+  private:
+    T value{ };
+
+    static void count( )
+    {
+        if( SortStats *stats = TrackMoves::current( ) )
+            ++stats->moves;
+    }
+};
+
+/*
+ * This is the more public version of insertion sort.
+ * It requires a pair of iterators and a comparison
+ * function object.
+ * #(compare is added)
+ * # @compare: less_than or greater_than, able to sort smallest to largest
+ *				or largest to smallest
+ */
+template <typename RandomIterator, typename Comparator>
+void insertionSort( const RandomIterator & begin,
+                    const RandomIterator & end,
+                    Comparator compare )
+{
+    if( begin == end )
+        return;
+        
+    RandomIterator j;
+
+    for( RandomIterator p = begin+1; p != end; ++p )
+    {
+        auto tmp = std::move( *p );
+        for( j = p; j != begin && compare( tmp, *( j-1 ) ); --j )
+            *j = std::move( *(j-1) );
+        *j = std::move( tmp );
+    }
+}
+
+/*
+ * The two-parameter version calls the three parameter version, using C++11 decltype
+ */
+template <typename RandomIterator>
+void insertionSort( const RandomIterator & begin,
+                    const RandomIterator & end )
+{
+    insertionSort( begin, end, less<decltype(*begin )>{ } );
+}
+
 /**
  * Simple insertion sort.
  * #(compare is added)
@@ -23,15 +380,13 @@ using namespace std;
 template <typename Comparable, typename Comparator>
 void insertionSort( vector<Comparable> & a , Comparator compare )
 {
-    for( int p = 1; p < a.size( ); ++p )
-    {
-        Comparable tmp = std::move( a[ p ] );
+    insertionSort( a.begin( ), a.end( ), compare );
+}
 
-        int j;
-        for( j = p; j > 0 && compare(tmp, a[ j - 1 ]); --j )
-            a[ j ] = std::move( a[ j - 1 ] );
-        a[ j ] = std::move( tmp );
-    }
+template <typename Comparable, typename Comparator>
+void insertionSort( span<Comparable> a, Comparator compare )
+{
+    insertionSort( a.begin( ), a.end( ), compare );
 }
 
 
@@ -45,9 +400,11 @@ void insertionSort( vector<Comparable> & a , Comparator compare )
  * # @compare: less_than or greater_than, able to sort vector from smallest to largest
  *				or from largest to smallest
  */
-template <typename Comparable, typename Comparator>
-void insertionSort( vector<Comparable> & a, int left, int right , Comparator compare )
+template <typename RandomIt, typename Comparator>
+void insertionSort( RandomIt a, int left, int right , Comparator compare )
 {
+    typedef typename iterator_traits<RandomIt>::value_type Comparable;
+
     for( int p = left + 1; p <= right; ++p )
     {
         Comparable tmp = std::move( a[ p ] );
@@ -59,16 +416,26 @@ void insertionSort( vector<Comparable> & a, int left, int right , Comparator com
     }
 }
 
+template <typename Comparable, typename Comparator>
+void insertionSort( vector<Comparable> & a, int left, int right , Comparator compare )
+{
+    insertionSort( a.data( ), left, right, compare );
+}
 
 
 /**
  * Shellsort, using Shell's (poor) increments.
+ * #(first and last are added; sorts the items in [ first, last ))
  */
-template <typename Comparable>
-void shellsort( vector<Comparable> & a )
+template <typename RandomIt>
+void shellsort( RandomIt first, RandomIt last )
 {
-    for( int gap = a.size( ) / 2; gap > 0; gap /= 2 )
-        for( int i = gap; i < a.size( ); ++i )
+    typedef typename iterator_traits<RandomIt>::value_type Comparable;
+    auto a = arrayBegin( first );
+    int n = checkedSize( first, last );
+
+    for( int gap = n / 2; gap > 0; gap /= 2 )
+        for( int i = gap; i < n; ++i )
         {
             Comparable tmp = std::move( a[ i ] );
             int j = i;
@@ -79,6 +446,17 @@ void shellsort( vector<Comparable> & a )
         }
 }
 
+template <typename Comparable>
+void shellsort( vector<Comparable> & a )
+{
+    shellsort( a.begin( ), a.end( ) );
+}
+
+template <typename Comparable>
+void shellsort( span<Comparable> a )
+{
+    shellsort( a.begin( ), a.end( ) );
+}
 
 
 /**
@@ -100,9 +478,10 @@ inline int leftChild( int i )
  * # @compare: less_than or greater_than, able to sort vector from smallest to largest
  *				or from largest to smallest
  */
-template <typename Comparable, typename Comparator>
-void percDown( vector<Comparable> & a, int i, int n, Comparator compare )
+template <typename RandomIt, typename Comparator>
+void percDown( RandomIt a, int i, int n, Comparator compare )
 {
+    typedef typename iterator_traits<RandomIt>::value_type Comparable;
     int child;
     Comparable tmp;
 
@@ -122,417 +501,3381 @@ void percDown( vector<Comparable> & a, int i, int n, Comparator compare )
 /**
  * Standard heapsort.
  * #(compare is added)
+ * #(first and last are added; sorts the items in [ first, last ),
+ *   the vector and span versions sort all their items)
  * # @compare: less_than or greater_than, able to sort vector from smallest to largest
  *				or from largest to smallest
  */
-template <typename Comparable,typename Comparator>
-void heapsort( vector<Comparable> & a, Comparator compare )
+template <typename RandomIt,typename Comparator>
+void heapsort( RandomIt first, RandomIt last, Comparator compare )
 {
-    for( int i = a.size( ) / 2 - 1; i >= 0; --i )  /* buildHeap */
-        percDown( a, i, a.size( ), compare);
-    for( int j = a.size( ) - 1; j > 0; --j )
+    auto a = arrayBegin( first );
+    int n = checkedSize( first, last );
+
+    for( int i = n / 2 - 1; i >= 0; --i )  /* buildHeap */
+        percDown( a, i, n, compare);
+    for( int j = n - 1; j > 0; --j )
     {
-        std::swap( a[ 0 ], a[ j ] );       /* deleteMax or deleteMin (delete the root of heap)*/
+        swapItems( a[ 0 ], a[ j ], compare );       /* deleteMax or deleteMin (delete the root of heap)*/
         percDown( a, 0, j, compare);
     }
 }
 
+template <typename Comparable,typename Comparator>
+void heapsort( vector<Comparable> & a, Comparator compare )
+{
+    heapsort( a.begin( ), a.end( ), compare );
+}
+
+template <typename Comparable,typename Comparator>
+void heapsort( span<Comparable> a, Comparator compare )
+{
+    heapsort( a.begin( ), a.end( ), compare );
+}
+
 /**
- * Internal method that merges two sorted halves of a subarray.
- * a is an array of Comparable items.
- * tmpArray is an array to place the merged result.
- * leftPos is the left-most index of the subarray.
- * rightPos is the index of the start of the second half.
- * rightEnd is the right-most index of the subarray.
- * #(compare is added)
- * # @compare: less_than or greater_than, able to sort vector from smallest to largest
- *				or from largest to smallest
+ * #(This class is added)
+ * Streaming top-K: keeps the k smallest items (for compare) of a stream
+ * of any length in O( k ) memory.
+ * Until k items have arrived they are only stored; then they become a
+ * binary heap (percDown) whose root is the largest item kept, so a new
+ * item costs one comparison with the root when it is rejected and
+ * O( log k ) when it replaces the root.
+ * Accumulators are not synchronized: give every thread its own one and
+ * merge them at the end. drain( ) returns the items in sorted order.
+ * # @compare: less_than or greater_than, keeps the k smallest or
+ *				the k largest items (e.g. greater for a leaderboard)
  */
-template <typename Comparable, typename Comparator>
-void merge( vector<Comparable> & a, vector<Comparable> & tmpArray,
-            int leftPos, int rightPos, int rightEnd, Comparator compare)
+template <typename Comparable, typename Comparator = less<Comparable> >
+class TopK
 {
-    int leftEnd = rightPos - 1;
-    int tmpPos = leftPos;
-    int numElements = rightEnd - leftPos + 1;
+  public:
+    explicit TopK( int k, Comparator comp = Comparator( ) )
+      : capacity( max( k, 0 ) ), compare( comp ) { }
 
-    // Main loop
-    while( leftPos <= leftEnd && rightPos <= rightEnd )
-        if(compare(a[ leftPos ] , a[ rightPos ]) || a[ leftPos ] == a[ rightPos ])
-            tmpArray[ tmpPos++ ] = std::move( a[ leftPos++ ] );
-        else
-            tmpArray[ tmpPos++ ] = std::move( a[ rightPos++ ] );
+    int size( ) const
+      { return int( items.size( ) ); }
 
-    while( leftPos <= leftEnd )    // Copy rest of first half
-        tmpArray[ tmpPos++ ] = std::move( a[ leftPos++ ] );
+    bool empty( ) const
+      { return items.empty( ); }
 
-    while( rightPos <= rightEnd )  // Copy rest of right half
-        tmpArray[ tmpPos++ ] = std::move( a[ rightPos++ ] );
+    /**
+     * Offers one item; it is kept if it is among the k smallest so far.
+     */
+    void push( const Comparable & x )
+    {
+        if( size( ) < capacity )
+            append( x );
+        else if( capacity > 0 && compare( x, items[ 0 ] ) )
+            replaceRoot( x );
+    }
 
-    // Copy tmpArray back
-    for( int i = 0; i < numElements; ++i, --rightEnd )
-        a[ rightEnd ] = std::move( tmpArray[ rightEnd ] );
-}
+    void push( Comparable && x )
+    {
+        if( size( ) < capacity )
+            append( std::move( x ) );
+        else if( capacity > 0 && compare( x, items[ 0 ] ) )
+            replaceRoot( std::move( x ) );
+    }
 
-/**
- * Internal method that makes recursive calls.
- * a is an array of Comparable items.
- * tmpArray is an array to place the merged result.
- * left is the left-most index of the subarray.
- * right is the right-most index of the subarray.
- * #(compare is added)
- * # @compare: less_than or greater_than, able to sort vector from smallest to largest
- *				or from largest to smallest
- */
-template <typename Comparable, typename Comparator>
-void mergeSort( vector<Comparable> & a,
-                vector<Comparable> & tmpArray, int left, int right, 
-				Comparator compare )
-{
-    if( left < right )
+    /**
+     * Offers the items of [ first, last ).
+     */
+    template <typename InputIt>
+    void push( InputIt first, InputIt last )
     {
-        int center = ( left + right ) / 2;
-        mergeSort( a, tmpArray, left, center , compare);
-        mergeSort( a, tmpArray, center + 1, right , compare);
-        merge( a, tmpArray, left, center + 1, right, compare);
+        for( ; first != last && size( ) < capacity; ++first )
+            append( *first );
+        if( capacity == 0 )
+            return;
+        for( ; first != last; ++first )      // Most items stop here
+            if( compare( *first, items[ 0 ] ) )
+                replaceRoot( *first );
     }
-}
 
-/**
- * Mergesort algorithm (driver).
- * #(compare is added)
- * # @compare: less_than or greater_than, able to sort vector from smallest to largest
- *				or from largest to smallest
- */
-template <typename Comparable, typename Comparator>
-void mergeSort( vector<Comparable> & a , Comparator compare)
-{
-    vector<Comparable> tmpArray( a.size( ) );
-    mergeSort( a, tmpArray, 0, a.size( ) - 1, compare);
-}
+    void push( span<const Comparable> batch )
+    {
+        push( batch.begin( ), batch.end( ) );
+    }
 
-/**
- * #(This function is added)
- * Set the middle element of vector a as new pivot
- * Swap pivot and the last element 
- * @Return pivot
+    /**
+     * Offers the items kept by other, e.g. the accumulator of another
+     * thread; other is left unchanged.
+     */
+    void merge( const TopK & other )
+    {
+        push( other.items.begin( ), other.items.end( ) );
+    }
+
+    /**
+     * Returns the items kept, sorted smallest first (for compare),
+     * and empties the accumulator.
+     */
+    vector<Comparable> drain( )
+    {
+        vector<Comparable> result;
+        result.swap( items );
+        heapsort( result, compare );
+        return result;
+    }
+
+  private:
+    int capacity;
+    Comparator compare;
+    vector<Comparable> items;    // A heap (root is the largest) once full
+
+    template <typename T>
+    void append( T && x )
+    {
+        items.push_back( std::forward<T>( x ) );
+        if( size( ) == capacity )            /* buildHeap */
+            for( int i = capacity / 2 - 1; i >= 0; --i )
+                percDown( items.data( ), i, capacity, compare );
+    }
+
+    template <typename T>
+    void replaceRoot( T && x )
+    {
+        items[ 0 ] = std::forward<T>( x );
+        percDown( items.data( ), 0, capacity, compare );
+    }
+};
+
+/**
+ * Internal class for dAryHeapsort: where the children of each node are.
+ * The Arity children of a node are stored together, and each group of
+ * them starts at an address that is a multiple of Arity items, so with
+ * Arity * sizeof( Comparable ) dividing 64 bytes no group spans two cache
+ * lines. skew is how far (in items) a[ 0 ] lies past such an address,
+ * since vector and malloc storage is only 16-byte aligned: the root has
+ * the Arity - 1 - skew children that fill its own group (the next whole
+ * group if that is none), and the groups of the nodes 1, 2, ... follow.
+ */
+template <int Arity>
+struct DAryLayout
+{
+    int skew;
+    int shift;      // 1 when the root has a whole group of children
+    int rootLast;   // Last child of the root
+
+    explicit DAryLayout( int skew )
+      : skew( skew ), shift( skew == Arity - 1 ), rootLast( skew == Arity - 1 ? Arity : Arity - 1 - skew ) { }
+
+    long long firstChild( int i ) const
+      { return i == 0 ? 1 : (long long) Arity * ( i + shift ) - skew; }
+
+    int lastChild( int i ) const
+      { return i == 0 ? rootLast : int( firstChild( i ) + Arity - 1 ); }
+
+    int parent( int child ) const
+      { return child <= rootLast ? 0 : int( ( (long long) child + skew ) / Arity ) - shift; }
+};
+
+/**
+ * Internal method for dAryHeapsort: the skew of the heap starting at a,
+ * 0 when the groups cannot be aligned (items behind a non-contiguous
+ * iterator, or groups that do not divide a cache line).
+ */
+template <int Arity, typename RandomIt>
+int dArySkew( RandomIt a )
+{
+    typedef typename iterator_traits<RandomIt>::value_type Comparable;
+    const size_t groupBytes = Arity * sizeof( Comparable );
+    if constexpr( is_pointer<RandomIt>::value )
+    {
+        uintptr_t address = reinterpret_cast<uintptr_t>( a );
+        if( 64 % groupBytes == 0 && address % sizeof( Comparable ) == 0 )
+            return int( address % groupBytes / sizeof( Comparable ) );
+    }
+    return 0;
+}
+
+/**
+ * Internal method for dAryHeapsort.
+ * Returns the largest child of i in a heap of n items (i must have one).
+ */
+template <int Arity, typename RandomIt, typename Comparator>
+int dAryLargestChild( RandomIt a, const DAryLayout<Arity> & layout, int i, int n, Comparator compare )
+{
+    int first = int( layout.firstChild( i ) );
+    int last = min( layout.lastChild( i ), n - 1 );
+    int largest = first;
+    for( int c = first + 1; c <= last; ++c )
+        if( compare( a[ largest ], a[ c ] ) )
+            largest = c;
+    return largest;
+}
+
+/**
+ * Internal method for dAryHeapsort that is used in buildHeap.
+ * i is the position from which to percolate down.
+ * n is the logical size of the heap.
+ */
+template <int Arity, typename RandomIt, typename Comparator>
+void dAryPercDown( RandomIt a, const DAryLayout<Arity> & layout, int i, int n, Comparator compare )
+{
+    typedef typename iterator_traits<RandomIt>::value_type Comparable;
+
+    Comparable tmp = std::move( a[ i ] );
+    while( layout.firstChild( i ) < n )
+    {
+        int child = dAryLargestChild( a, layout, i, n, compare );
+        if( !compare( tmp, a[ child ] ) )
+            break;
+        a[ i ] = std::move( a[ child ] );
+        i = child;
+    }
+    a[ i ] = std::move( tmp );
+}
+
+/**
+ * #(This function is added)
+ * Heapsort with a heap of compile-time arity (4 or 8), for example
+ * dAryHeapsort<4>( a, less<int>{ } ).
+ * A wider heap is shallower, and the children of a node are laid out in
+ * one cache line when Arity items fit one (see DAryLayout), whatever the
+ * alignment of the array.
+ * deleteMax sinks the hole at the root straight to a leaf along the largest
+ * children (Arity - 1 comparisons per level, none against the moved item),
+ * then sifts the last item up from there, which is usually a short way.
+ * # @compare: less_than or greater_than, able to sort vector from smallest to largest
+ *				or from largest to smallest
+ */
+template <int Arity, typename RandomIt, typename Comparator>
+void dAryHeapsort( RandomIt first, RandomIt last, Comparator compare )
+{
+    static_assert( Arity >= 2, "dAryHeapsort needs an arity of at least 2" );
+    typedef typename iterator_traits<RandomIt>::value_type Comparable;
+
+    auto a = arrayBegin( first );
+    int n = checkedSize( first, last );
+    if( n < 2 )
+        return;
+    const DAryLayout<Arity> layout( dArySkew<Arity>( a ) );
+
+    for( int i = layout.parent( n - 1 ); i >= 0; --i )  /* buildHeap */
+        dAryPercDown( a, layout, i, n, compare );
+
+    for( int j = n - 1; j > 0; --j )   /* deleteMax */
+    {
+        Comparable tmp = std::move( a[ j ] );
+        a[ j ] = std::move( a[ 0 ] );
+
+        int hole = 0;   // Sink the hole to a leaf
+        while( layout.firstChild( hole ) < j )
+        {
+            int child = dAryLargestChild( a, layout, hole, j, compare );
+            a[ hole ] = std::move( a[ child ] );
+            hole = child;
+        }
+        while( hole > 0 )   // Sift tmp back up
+        {
+            int parent = layout.parent( hole );
+            if( !compare( a[ parent ], tmp ) )
+                break;
+            a[ hole ] = std::move( a[ parent ] );
+            hole = parent;
+        }
+        a[ hole ] = std::move( tmp );
+    }
+}
+
+template <int Arity, typename Comparable, typename Comparator>
+void dAryHeapsort( vector<Comparable> & a, Comparator compare )
+{
+    dAryHeapsort<Arity>( a.begin( ), a.end( ), compare );
+}
+
+template <int Arity, typename Comparable, typename Comparator>
+void dAryHeapsort( span<Comparable> a, Comparator compare )
+{
+    dAryHeapsort<Arity>( a.begin( ), a.end( ), compare );
+}
+
+/**
+ * Internal method for heapsort of a subarray.
+ * Same as percDown, for the heap stored in a[ left .. left + n - 1 ].
+ * i is the position (relative to left) from which to percolate down.
+ */
+template <typename RandomIt, typename Comparator>
+void percDown( RandomIt a, int left, int i, int n, Comparator compare )
+{
+    typedef typename iterator_traits<RandomIt>::value_type Comparable;
+    int child;
+    Comparable tmp;
+
+    for( tmp = std::move( a[ left + i ] ); leftChild( i ) < n; i = child )
+    {
+        child = leftChild( i );
+        if( child != n - 1 && compare( a[ left + child ], a[ left + child + 1 ] ) )
+            ++child;
+        if( compare( tmp, a[ left + child ] ) )
+            a[ left + i ] = std::move( a[ left + child ] );
+        else
+            break;
+    }
+    a[ left + i ] = std::move( tmp );
+}
+
+/**
+ * Heapsort of the subarray a[ left .. right ].
+ * Used by introsort when quicksort keeps partitioning badly.
+ */
+template <typename RandomIt, typename Comparator>
+void heapsort( RandomIt a, int left, int right, Comparator compare )
+{
+    int n = right - left + 1;
+    for( int i = n / 2 - 1; i >= 0; --i )  /* buildHeap */
+        percDown( a, left, i, n, compare );
+    for( int j = n - 1; j > 0; --j )
+    {
+        swapItems( a[ left ], a[ left + j ], compare );
+        percDown( a, left, 0, j, compare );
+    }
+}
+
+template <typename Comparable, typename Comparator>
+void heapsort( vector<Comparable> & a, int left, int right, Comparator compare )
+{
+    heapsort( a.data( ), left, right, compare );
+}
+
+/**
+ * Internal method that merges two sorted halves of a subarray.
+ * a is an array of Comparable items.
+ * tmpArray is an array to place the merged result.
+ * leftPos is the left-most index of the subarray.
+ * rightPos is the index of the start of the second half.
+ * rightEnd is the right-most index of the subarray.
+ * #(compare is added)
+ * # @compare: less_than or greater_than, able to sort vector from smallest to largest
+ *				or from largest to smallest
+ */
+template <typename RandomIt, typename TmpIt, typename Comparator>
+void merge( RandomIt a, TmpIt tmpArray,
+            int leftPos, int rightPos, int rightEnd, Comparator compare)
+{
+    int leftEnd = rightPos - 1;
+    int tmpPos = leftPos;
+    int numElements = rightEnd - leftPos + 1;
+
+    // Main loop
+    while( leftPos <= leftEnd && rightPos <= rightEnd )
+        if( !compare( a[ rightPos ], a[ leftPos ] ) )   // ties keep the left item first (stable)
+            tmpArray[ tmpPos++ ] = std::move( a[ leftPos++ ] );
+        else
+            tmpArray[ tmpPos++ ] = std::move( a[ rightPos++ ] );
+
+    while( leftPos <= leftEnd )    // Copy rest of first half
+        tmpArray[ tmpPos++ ] = std::move( a[ leftPos++ ] );
+
+    while( rightPos <= rightEnd )  // Copy rest of right half
+        tmpArray[ tmpPos++ ] = std::move( a[ rightPos++ ] );
+
+    // Copy tmpArray back
+    for( int i = 0; i < numElements; ++i, --rightEnd )
+        a[ rightEnd ] = std::move( tmpArray[ rightEnd ] );
+}
+
+/**
+ * Internal method that makes recursive calls.
+ * a is an array of Comparable items.
+ * tmpArray is an array to place the merged result.
+ * left is the left-most index of the subarray.
+ * right is the right-most index of the subarray.
+ * #(compare is added)
+ * # @compare: less_than or greater_than, able to sort vector from smallest to largest
+ *				or from largest to smallest
+ */
+template <typename RandomIt, typename TmpIt, typename Comparator>
+void mergeSort( RandomIt a,
+                TmpIt tmpArray, int left, int right, 
+				Comparator compare )
+{
+    RecursionLevel<Comparator> level( compare );
+    if( left < right )
+    {
+        int center = ( left + right ) / 2;
+        mergeSort( a, tmpArray, left, center , compare);
+        mergeSort( a, tmpArray, center + 1, right , compare);
+        ::merge( a, tmpArray, left, center + 1, right, compare);   // Not std::merge
+    }
+}
+
+template <typename Comparable, typename Comparator>
+void mergeSort( vector<Comparable> & a,
+                vector<Comparable> & tmpArray, int left, int right,
+                Comparator compare )
+{
+    mergeSort( a.data( ), tmpArray.data( ), left, right, compare );
+}
+
+/**
+ * Mergesort algorithm (driver).
+ * #(compare is added)
+ * #(first and last are added; sorts the items in [ first, last ),
+ *   the vector and span versions sort all their items)
+ * #(items that IndirectSort selects are sorted through an array of
+ *   indexes and then moved once each)
+ * # @compare: less_than or greater_than, able to sort vector from smallest to largest
+ *				or from largest to smallest
+ */
+template <typename RandomIt, typename Comparator>
+void mergeSort( RandomIt first, RandomIt last, Comparator compare )
+{
+    typedef typename iterator_traits<RandomIt>::value_type Comparable;
+    auto a = arrayBegin( first );
+    int n = checkedSize( first, last );
+    if constexpr( IndirectSort<Comparable>::mergeSort )
+    {
+        vector<uint32_t> perm = identityPermutation<uint32_t>( n );
+        vector<uint32_t> tmpArray( n );
+        mergeSort( perm.data( ), tmpArray.data( ), 0, n - 1, IndirectCompare<decltype( a ), Comparator>{ a, compare } );
+        applyPermutation( perm, a );
+    }
+    else
+    {
+        vector<Comparable> tmpArray( n );
+        mergeSort( a, tmpArray.data( ), 0, n - 1, compare );
+    }
+}
+
+template <typename Comparable, typename Comparator>
+void mergeSort( vector<Comparable> & a , Comparator compare)
+{
+    mergeSort( a.begin( ), a.end( ), compare );
+}
+
+template <typename Comparable, typename Comparator>
+void mergeSort( span<Comparable> a, Comparator compare )
+{
+    mergeSort( a.begin( ), a.end( ), compare );
+}
+
+/**
+ * Runs of this many items are insertion sorted before
+ * mergeSortBottomUp starts merging.
+ */
+const int MERGE_SORT_LEAF = 32;
+
+/**
+ * Internal method for mergeSortBottomUp.
+ * Insertion sorts from[ left .. right ] into to[ left .. right ].
+ */
+template <typename FromIt, typename ToIt, typename Comparator>
+void insertionSortInto( FromIt from, ToIt to, int left, int right, Comparator compare )
+{
+    for( int p = left; p <= right; ++p )
+    {
+        int j;
+        for( j = p; j > left && compare( from[ p ], to[ j - 1 ] ); --j )
+            to[ j ] = std::move( to[ j - 1 ] );
+        to[ j ] = std::move( from[ p ] );
+    }
+}
+
+/**
+ * Internal method for mergeSortBottomUp.
+ * Merges from[ leftPos .. rightPos - 1 ] and from[ rightPos .. rightEnd ]
+ * into to[ leftPos .. rightEnd ]. Nothing is copied back.
+ */
+template <typename FromIt, typename ToIt, typename Comparator>
+void mergeRuns( FromIt from, ToIt to,
+                int leftPos, int rightPos, int rightEnd, Comparator compare )
+{
+    int leftEnd = rightPos - 1;
+    int toPos = leftPos;
+
+    while( leftPos <= leftEnd && rightPos <= rightEnd )
+        if( !compare( from[ rightPos ], from[ leftPos ] ) )
+            to[ toPos++ ] = std::move( from[ leftPos++ ] );
+        else
+            to[ toPos++ ] = std::move( from[ rightPos++ ] );
+
+    while( leftPos <= leftEnd )    // Copy rest of first run
+        to[ toPos++ ] = std::move( from[ leftPos++ ] );
+
+    while( rightPos <= rightEnd )  // Copy rest of second run
+        to[ toPos++ ] = std::move( from[ rightPos++ ] );
+}
+
+/**
+ * #(This function is added)
+ * Bottom-up mergesort (stable).
+ * Runs of MERGE_SORT_LEAF items are insertion sorted first, then each pass
+ * merges pairs of runs of the same width from one buffer into the other
+ * and the buffers swap roles, so an item moves once per pass instead of
+ * twice (mergeSort copies tmpArray back after every merge).
+ * When the number of passes is odd the leaves are sorted straight into
+ * tmpArray, so the last pass always ends in a.
+ * #(first and last are added; sorts the items in [ first, last ))
+ * # @compare: less_than or greater_than, able to sort vector from smallest to largest
+ *				or from largest to smallest
+ */
+template <typename RandomIt, typename Comparator>
+void mergeSortBottomUp( RandomIt first, RandomIt last, Comparator compare )
+{
+    typedef typename iterator_traits<RandomIt>::value_type Comparable;
+    auto a = arrayBegin( first );
+    int n = checkedSize( first, last );
+    if( n <= MERGE_SORT_LEAF )
+    {
+        insertionSort( a, 0, n - 1, compare );
+        return;
+    }
+
+    int passes = 0;
+    for( long long width = MERGE_SORT_LEAF; width < n; width *= 2 )
+        ++passes;
+
+    vector<Comparable> tmpArray( n );
+    Comparable *tmp = tmpArray.data( );
+    bool inTmp = passes % 2 != 0;   // The runs are in tmpArray, not in a
+    for( int left = 0; left < n; left += MERGE_SORT_LEAF )
+    {
+        int right = min( left + MERGE_SORT_LEAF, n ) - 1;
+        if( !inTmp )
+            insertionSort( a, left, right, compare );
+        else
+            insertionSortInto( a, tmp, left, right, compare );
+    }
+
+    for( long long width = MERGE_SORT_LEAF; width < n; width *= 2 )
+    {
+        for( long long leftPos = 0; leftPos < n; leftPos += 2 * width )
+        {
+            int rightPos = min<long long>( leftPos + width, n );
+            int rightEnd = min<long long>( leftPos + 2 * width, n ) - 1;
+            if( inTmp )
+                mergeRuns( tmp, a, leftPos, rightPos, rightEnd, compare );
+            else
+                mergeRuns( a, tmp, leftPos, rightPos, rightEnd, compare );
+        }
+        inTmp = !inTmp;
+    }
+}
+
+template <typename Comparable, typename Comparator>
+void mergeSortBottomUp( vector<Comparable> & a, Comparator compare )
+{
+    mergeSortBottomUp( a.begin( ), a.end( ), compare );
+}
+
+template <typename Comparable, typename Comparator>
+void mergeSortBottomUp( span<Comparable> a, Comparator compare )
+{
+    mergeSortBottomUp( a.begin( ), a.end( ), compare );
+}
+
+/**
+ * #(This class is added)
+ * Tournament (loser) tree over k sorted sources.
+ * A source is anything with empty( ), front( ) and pop( ) (RangeSource
+ * below, or a run file reader); the tree is itself such a source and
+ * yields the items of all of them in sorted order. Each internal node
+ * keeps the source that lost the match played there and node 0 the
+ * overall winner, so pop( ) replays only the path from the winner's
+ * leaf to the root: ceil( log2( k ) ) comparisons per item.
+ * Ties go to the source with the smaller index (stable, like merge).
+ * The sources are not owned and must outlive the tree.
+ * # @compare: less_than or greater_than, able to merge smallest to largest
+ *				or largest to smallest
+ */
+template <typename Source, typename Comparator>
+class LoserTree
+{
+  public:
+    LoserTree( const vector<Source *> & sources, Comparator comp )
+      : src( sources ), k( (int) sources.size( ) ), tree( max( k, 1 ) ), compare( comp )
+    {
+        if( k > 0 )
+            tree[ 0 ] = build( 1 );
+    }
+
+    bool empty( ) const
+      { return k == 0 || src[ tree[ 0 ] ]->empty( ); }
+
+    const auto & front( ) const
+      { return src[ tree[ 0 ] ]->front( ); }
+
+    /**
+     * Removes the smallest item and plays the winner's source again
+     * against the losers on its path to the root.
+     */
+    void pop( )
+    {
+        int winner = tree[ 0 ];
+        src[ winner ]->pop( );
+        for( int node = ( winner + k ) / 2; node > 0; node /= 2 )
+            if( beats( tree[ node ], winner ) )
+                std::swap( tree[ node ], winner );
+        tree[ 0 ] = winner;
+    }
+
+  private:
+    vector<Source *> src;
+    int k;
+    vector<int> tree;        // Leaves are the nodes k .. 2k - 1: source node - k
+    Comparator compare;
+
+    /**
+     * Whether source x comes out before source y; an empty source loses.
+     */
+    bool beats( int x, int y ) const
+    {
+        if( src[ y ]->empty( ) )
+            return !src[ x ]->empty( );
+        if( src[ x ]->empty( ) )
+            return false;
+        if( x < y )
+            return !compare( src[ y ]->front( ), src[ x ]->front( ) );
+        return compare( src[ x ]->front( ), src[ y ]->front( ) );
+    }
+
+    /**
+     * Plays the matches of the subtree rooted at node; returns its winner.
+     */
+    int build( int node )
+    {
+        if( node >= k )
+            return node - k;
+        int left = build( 2 * node );
+        int right = build( 2 * node + 1 );
+        if( beats( right, left ) )
+            std::swap( left, right );
+        tree[ node ] = right;
+        return left;
+    }
+};
+
+/**
+ * Source of a LoserTree reading the sorted range [ first, last ).
+ */
+template <typename InputIt>
+struct RangeSource
+{
+    InputIt first;
+    InputIt last;
+
+    bool empty( ) const
+      { return first == last; }
+
+    const typename iterator_traits<InputIt>::value_type & front( ) const
+      { return *first; }
+
+    void pop( )
+      { ++first; }
+};
+
+/**
+ * #(This function is added)
+ * k-way merge: writes the items of the sorted ranges runs[ i ] =
+ * [ first, last ) to out in sorted order and returns the end of the output.
+ * The output is streamed through a LoserTree, about log2( k ) comparisons
+ * per item, with no intermediate pairwise merges. Stable: equal items keep
+ * the order of their ranges. The ranges must not overlap the output.
+ * # @compare: less_than or greater_than, the order the ranges are sorted in
+ */
+template <typename InputIt, typename OutputIt, typename Comparator>
+OutputIt kWayMerge( const vector<pair<InputIt, InputIt> > & runs, OutputIt out, Comparator compare )
+{
+    vector<RangeSource<InputIt> > sources;
+    for( const auto & run : runs )
+        sources.push_back( { run.first, run.second } );
+    vector<RangeSource<InputIt> *> pointers;
+    for( auto & source : sources )
+        pointers.push_back( &source );
+
+    for( LoserTree<RangeSource<InputIt>, Comparator> tree( pointers, compare ); !tree.empty( ); tree.pop( ) )
+        *out++ = tree.front( );
+    return out;
+}
+
+template <typename Comparable, typename OutputIt, typename Comparator>
+OutputIt kWayMerge( const vector<vector<Comparable> > & runs, OutputIt out, Comparator compare )
+{
+    typedef typename vector<Comparable>::const_iterator Iterator;
+    vector<pair<Iterator, Iterator> > ranges;
+    for( const vector<Comparable> & run : runs )
+        ranges.emplace_back( run.begin( ), run.end( ) );
+    return kWayMerge( ranges, out, compare );
+}
+
+/**
+ * Shortest run timSort merges; shorter natural runs are extended
+ * by binary insertion sort.
+ */
+const int TIMSORT_MIN_MERGE = 32;
+
+/**
+ * Number of consecutive wins of one run after which
+ * timSort switches to galloping.
+ */
+const int TIMSORT_MIN_GALLOP = 7;
+
+/**
+ * Adaptive natural mergesort (TimSort).
+ * Finds the runs already present in the input (strictly descending runs
+ * are reversed), extends short runs to minRun items by binary insertion
+ * sort and keeps the pending runs on a stack whose lengths grow at least
+ * like the Fibonacci numbers, merging neighbours when that invariant
+ * breaks. Merges gallop (exponential search) once one run keeps winning.
+ * Sorted input takes n - 1 comparisons; input made of r runs about
+ * n log2( r ).
+ * Use the timSort( a, compare ) driver.
+ * #(array is a random access iterator to the size items to sort)
+ */
+template <typename RandomIt, typename Comparator>
+class TimSort
+{
+  public:
+    typedef typename iterator_traits<RandomIt>::value_type Comparable;
+
+    TimSort( RandomIt array, int size, Comparator comp )
+      : a( array ), n( size ), compare( comp ), minGallop( TIMSORT_MIN_GALLOP ) { }
+
+    void sort( )
+    {
+        int lo = 0;
+        int remaining = n;
+        if( remaining < 2 )
+            return;
+
+        if( remaining < TIMSORT_MIN_MERGE )  // One binary insertion sort, no merges
+        {
+            int initRunLen = countRunAndMakeAscending( lo, remaining );
+            binaryInsertionSort( lo, remaining, lo + initRunLen );
+            return;
+        }
+
+        int minRun = minRunLength( remaining );
+        do
+        {
+            int runLen = countRunAndMakeAscending( lo, lo + remaining );
+            if( runLen < minRun )
+            {
+                int force = min( remaining, minRun );
+                binaryInsertionSort( lo, lo + force, lo + runLen );
+                runLen = force;
+            }
+
+            runBase.push_back( lo );
+            runLen_.push_back( runLen );
+            mergeCollapse( );
+
+            lo += runLen;
+            remaining -= runLen;
+        } while( remaining != 0 );
+
+        mergeForceCollapse( );
+    }
+
+  private:
+    RandomIt a;
+    int n;
+    Comparator compare;
+    vector<Comparable> tmp;
+    int minGallop;
+    vector<int> runBase;   // Stack of pending runs
+    vector<int> runLen_;
+
+    /**
+     * n if n < TIMSORT_MIN_MERGE, else a length between MIN_MERGE / 2 and
+     * MIN_MERGE such that n / minRun is (close to) a power of two.
+     */
+    static int minRunLength( int n )
+    {
+        int r = 0;
+        while( n >= TIMSORT_MIN_MERGE )
+        {
+            r |= n & 1;
+            n >>= 1;
+        }
+        return n + r;
+    }
+
+    /**
+     * Returns the length of the run starting at lo (hi is exclusive).
+     * A strictly descending run is reversed in place.
+     */
+    int countRunAndMakeAscending( int lo, int hi )
+    {
+        int runHi = lo + 1;
+        if( runHi == hi )
+            return 1;
+
+        if( compare( a[ runHi++ ], a[ lo ] ) )
+        {
+            while( runHi < hi && compare( a[ runHi ], a[ runHi - 1 ] ) )
+                ++runHi;
+            std::reverse( a + lo, a + runHi );
+        }
+        else
+            while( runHi < hi && !compare( a[ runHi ], a[ runHi - 1 ] ) )
+                ++runHi;
+
+        return runHi - lo;
+    }
+
+    /**
+     * Sorts a[ lo .. hi - 1 ] when a[ lo .. start - 1 ] is already sorted.
+     * Each item goes after the equal items (stable).
+     */
+    void binaryInsertionSort( int lo, int hi, int start )
+    {
+        for( ; start < hi; ++start )
+        {
+            Comparable pivot = std::move( a[ start ] );
+            int left = lo, right = start;
+            while( left < right )
+            {
+                int mid = ( left + right ) >> 1;
+                if( compare( pivot, a[ mid ] ) )
+                    right = mid;
+                else
+                    left = mid + 1;
+            }
+            std::move_backward( a + left, a + start, a + start + 1 );
+            a[ left ] = std::move( pivot );
+        }
+    }
+
+    /**
+     * Next offset of an exponential search, capped at maxOfs.
+     */
+    static int nextOffset( int ofs, int maxOfs )
+    {
+        return ofs < maxOfs / 2 ? ( ofs << 1 ) + 1 : maxOfs;
+    }
+
+    /**
+     * Position where key goes in the sorted run v[ base .. base + len - 1 ],
+     * before any equal items. The search starts at base + hint.
+     */
+    template <typename Array>
+    int gallopLeft( const Comparable & key, const Array & v, int base, int len, int hint )
+    {
+        int lastOfs = 0, ofs = 1;
+        if( compare( v[ base + hint ], key ) )
+        {
+                // Gallop right until v[ base + hint + lastOfs ] < key <= v[ base + hint + ofs ]
+            int maxOfs = len - hint;
+            while( ofs < maxOfs && compare( v[ base + hint + ofs ], key ) )
+            {
+                lastOfs = ofs;
+                ofs = nextOffset( ofs, maxOfs );
+            }
+            if( ofs > maxOfs )
+                ofs = maxOfs;
+            lastOfs += hint;
+            ofs += hint;
+        }
+        else
+        {
+                // Gallop left until v[ base + hint - ofs ] < key <= v[ base + hint - lastOfs ]
+            int maxOfs = hint + 1;
+            while( ofs < maxOfs && !compare( v[ base + hint - ofs ], key ) )
+            {
+                lastOfs = ofs;
+                ofs = nextOffset( ofs, maxOfs );
+            }
+            if( ofs > maxOfs )
+                ofs = maxOfs;
+            int t = lastOfs;
+            lastOfs = hint - ofs;
+            ofs = hint - t;
+        }
+
+            // Binary search in ( lastOfs, ofs ]
+        ++lastOfs;
+        while( lastOfs < ofs )
+        {
+            int m = lastOfs + ( ( ofs - lastOfs ) >> 1 );
+            if( compare( v[ base + m ], key ) )
+                lastOfs = m + 1;
+            else
+                ofs = m;
+        }
+        return ofs;
+    }
+
+    /**
+     * Position where key goes in the sorted run v[ base .. base + len - 1 ],
+     * after any equal items. The search starts at base + hint.
+     */
+    template <typename Array>
+    int gallopRight( const Comparable & key, const Array & v, int base, int len, int hint )
+    {
+        int lastOfs = 0, ofs = 1;
+        if( compare( key, v[ base + hint ] ) )
+        {
+                // Gallop left until v[ base + hint - ofs ] <= key < v[ base + hint - lastOfs ]
+            int maxOfs = hint + 1;
+            while( ofs < maxOfs && compare( key, v[ base + hint - ofs ] ) )
+            {
+                lastOfs = ofs;
+                ofs = nextOffset( ofs, maxOfs );
+            }
+            if( ofs > maxOfs )
+                ofs = maxOfs;
+            int t = lastOfs;
+            lastOfs = hint - ofs;
+            ofs = hint - t;
+        }
+        else
+        {
+                // Gallop right until v[ base + hint + lastOfs ] <= key < v[ base + hint + ofs ]
+            int maxOfs = len - hint;
+            while( ofs < maxOfs && !compare( key, v[ base + hint + ofs ] ) )
+            {
+                lastOfs = ofs;
+                ofs = nextOffset( ofs, maxOfs );
+            }
+            if( ofs > maxOfs )
+                ofs = maxOfs;
+            lastOfs += hint;
+            ofs += hint;
+        }
+
+            // Binary search in ( lastOfs, ofs ]
+        ++lastOfs;
+        while( lastOfs < ofs )
+        {
+            int m = lastOfs + ( ( ofs - lastOfs ) >> 1 );
+            if( compare( key, v[ base + m ] ) )
+                ofs = m;
+            else
+                lastOfs = m + 1;
+        }
+        return ofs;
+    }
+
+    /**
+     * Merges neighbouring runs until the stack invariants hold again:
+     * runLen[ i - 2 ] > runLen[ i - 1 ] + runLen[ i ] and
+     * runLen[ i - 1 ] > runLen[ i ].
+     */
+    void mergeCollapse( )
+    {
+        while( runLen_.size( ) > 1 )
+        {
+            int n = runLen_.size( ) - 2;
+            if( ( n > 0 && runLen_[ n - 1 ] <= runLen_[ n ] + runLen_[ n + 1 ] )
+                || ( n > 1 && runLen_[ n - 2 ] <= runLen_[ n ] + runLen_[ n - 1 ] ) )
+            {
+                if( runLen_[ n - 1 ] < runLen_[ n + 1 ] )
+                    --n;
+            }
+            else if( runLen_[ n ] > runLen_[ n + 1 ] )
+                break;
+            mergeAt( n );
+        }
+    }
+
+    /**
+     * Merges all runs left on the stack.
+     */
+    void mergeForceCollapse( )
+    {
+        while( runLen_.size( ) > 1 )
+        {
+            int n = runLen_.size( ) - 2;
+            if( n > 0 && runLen_[ n - 1 ] < runLen_[ n + 1 ] )
+                --n;
+            mergeAt( n );
+        }
+    }
+
+    /**
+     * Merges the runs at stack positions i and i + 1.
+     * Items of the first run that are not greater than the start of the
+     * second run, and items of the second run that are not smaller than
+     * the end of the first run, are already in place and are skipped.
+     */
+    void mergeAt( int i )
+    {
+        int base1 = runBase[ i ], len1 = runLen_[ i ];
+        int base2 = runBase[ i + 1 ], len2 = runLen_[ i + 1 ];
+
+        runLen_[ i ] = len1 + len2;
+        runBase.erase( runBase.begin( ) + i + 1 );
+        runLen_.erase( runLen_.begin( ) + i + 1 );
+
+        int k = gallopRight( a[ base2 ], a, base1, len1, 0 );
+        base1 += k;
+        len1 -= k;
+        if( len1 == 0 )
+            return;
+
+        len2 = gallopLeft( a[ base1 + len1 - 1 ], a, base2, len2, len2 - 1 );
+        if( len2 == 0 )
+            return;
+
+        if( len1 <= len2 )
+            mergeLo( base1, len1, base2, len2 );
+        else
+            mergeHi( base1, len1, base2, len2 );
+    }
+
+    void ensureCapacity( int n )
+    {
+        if( (int) tmp.size( ) < n )
+            tmp.resize( n );
+    }
+
+    /**
+     * Merges the adjacent runs from the left, with the first (shorter) run
+     * moved to tmp. a[ base1 ] must be greater than a[ base2 ] and the
+     * last item of the first run greater than every item of the second.
+     */
+    void mergeLo( int base1, int len1, int base2, int len2 )
+    {
+        ensureCapacity( len1 );
+        std::move( a + base1, a + base1 + len1, tmp.begin( ) );
+
+        int cursor1 = 0;       // Index into tmp
+        int cursor2 = base2;   // Index into a
+        int dest = base1;      // Index into a
+
+        a[ dest++ ] = std::move( a[ cursor2++ ] );
+        if( --len2 == 0 )
+        {
+            std::move( tmp.begin( ) + cursor1, tmp.begin( ) + cursor1 + len1, a + dest );
+            return;
+        }
+        if( len1 == 1 )
+        {
+            std::move( a + cursor2, a + cursor2 + len2, a + dest );
+            a[ dest + len2 ] = std::move( tmp[ cursor1 ] );
+            return;
+        }
+
+        bool done = false;
+        while( !done )
+        {
+            int count1 = 0;   // Number of times in a row the first run won
+            int count2 = 0;   // Number of times in a row the second run won
+
+                // One item at a time until one run starts winning consistently
+            do
+            {
+                if( compare( a[ cursor2 ], tmp[ cursor1 ] ) )
+                {
+                    a[ dest++ ] = std::move( a[ cursor2++ ] );
+                    ++count2;
+                    count1 = 0;
+                    if( --len2 == 0 )
+                        done = true;
+                }
+                else
+                {
+                    a[ dest++ ] = std::move( tmp[ cursor1++ ] );
+                    ++count1;
+                    count2 = 0;
+                    if( --len1 == 1 )
+                        done = true;
+                }
+            } while( !done && ( count1 | count2 ) < minGallop );
+            if( done )
+                break;
+
+                // Gallop until neither run is winning consistently
+            do
+            {
+                count1 = gallopRight( a[ cursor2 ], tmp, cursor1, len1, 0 );
+                if( count1 != 0 )
+                {
+                    std::move( tmp.begin( ) + cursor1, tmp.begin( ) + cursor1 + count1, a + dest );
+                    dest += count1;
+                    cursor1 += count1;
+                    len1 -= count1;
+                    if( len1 <= 1 )
+                    {
+                        done = true;
+                        break;
+                    }
+                }
+                a[ dest++ ] = std::move( a[ cursor2++ ] );
+                if( --len2 == 0 )
+                {
+                    done = true;
+                    break;
+                }
+
+                count2 = gallopLeft( tmp[ cursor1 ], a, cursor2, len2, 0 );
+                if( count2 != 0 )
+                {
+                    std::move( a + cursor2, a + cursor2 + count2, a + dest );
+                    dest += count2;
+                    cursor2 += count2;
+                    len2 -= count2;
+                    if( len2 == 0 )
+                    {
+                        done = true;
+                        break;
+                    }
+                }
+                a[ dest++ ] = std::move( tmp[ cursor1++ ] );
+                if( --len1 == 1 )
+                {
+                    done = true;
+                    break;
+                }
+                --minGallop;
+            } while( count1 >= TIMSORT_MIN_GALLOP || count2 >= TIMSORT_MIN_GALLOP );
+            if( done )
+                break;
+
+            if( minGallop < 0 )
+                minGallop = 0;
+            minGallop += 2;   // Penalize leaving gallop mode
+        }
+        if( minGallop < 1 )
+            minGallop = 1;
+
+        if( len1 == 1 )
+        {
+            std::move( a + cursor2, a + cursor2 + len2, a + dest );
+            a[ dest + len2 ] = std::move( tmp[ cursor1 ] );
+        }
+        else   // len2 == 0
+            std::move( tmp.begin( ) + cursor1, tmp.begin( ) + cursor1 + len1, a + dest );
+    }
+
+    /**
+     * Merges the adjacent runs from the right, with the second (shorter)
+     * run moved to tmp. Same preconditions as mergeLo.
+     */
+    void mergeHi( int base1, int len1, int base2, int len2 )
+    {
+        ensureCapacity( len2 );
+        std::move( a + base2, a + base2 + len2, tmp.begin( ) );
+
+        int cursor1 = base1 + len1 - 1;   // Index into a
+        int cursor2 = len2 - 1;           // Index into tmp
+        int dest = base2 + len2 - 1;      // Index into a
+
+        a[ dest-- ] = std::move( a[ cursor1-- ] );
+        if( --len1 == 0 )
+        {
+            std::move( tmp.begin( ), tmp.begin( ) + len2, a + dest - ( len2 - 1 ) );
+            return;
+        }
+        if( len2 == 1 )
+        {
+            dest -= len1;
+            cursor1 -= len1;
+            std::move_backward( a + cursor1 + 1, a + cursor1 + 1 + len1,
+                                a + dest + 1 + len1 );
+            a[ dest ] = std::move( tmp[ cursor2 ] );
+            return;
+        }
+
+        bool done = false;
+        while( !done )
+        {
+            int count1 = 0;   // Number of times in a row the first run won
+            int count2 = 0;   // Number of times in a row the second run won
+
+                // One item at a time until one run starts winning consistently
+            do
+            {
+                if( compare( tmp[ cursor2 ], a[ cursor1 ] ) )
+                {
+                    a[ dest-- ] = std::move( a[ cursor1-- ] );
+                    ++count1;
+                    count2 = 0;
+                    if( --len1 == 0 )
+                        done = true;
+                }
+                else
+                {
+                    a[ dest-- ] = std::move( tmp[ cursor2-- ] );
+                    ++count2;
+                    count1 = 0;
+                    if( --len2 == 1 )
+                        done = true;
+                }
+            } while( !done && ( count1 | count2 ) < minGallop );
+            if( done )
+                break;
+
+                // Gallop until neither run is winning consistently
+            do
+            {
+                count1 = len1 - gallopRight( tmp[ cursor2 ], a, base1, len1, len1 - 1 );
+                if( count1 != 0 )
+                {
+                    dest -= count1;
+                    cursor1 -= count1;
+                    len1 -= count1;
+                    std::move_backward( a + cursor1 + 1, a + cursor1 + 1 + count1,
+                                        a + dest + 1 + count1 );
+                    if( len1 == 0 )
+                    {
+                        done = true;
+                        break;
+                    }
+                }
+                a[ dest-- ] = std::move( tmp[ cursor2-- ] );
+                if( --len2 == 1 )
+                {
+                    done = true;
+                    break;
+                }
+
+                count2 = len2 - gallopLeft( a[ cursor1 ], tmp, 0, len2, len2 - 1 );
+                if( count2 != 0 )
+                {
+                    dest -= count2;
+                    cursor2 -= count2;
+                    len2 -= count2;
+                    std::move( tmp.begin( ) + cursor2 + 1, tmp.begin( ) + cursor2 + 1 + count2,
+                               a + dest + 1 );
+                    if( len2 <= 1 )
+                    {
+                        done = true;
+                        break;
+                    }
+                }
+                a[ dest-- ] = std::move( a[ cursor1-- ] );
+                if( --len1 == 0 )
+                {
+                    done = true;
+                    break;
+                }
+                --minGallop;
+            } while( count1 >= TIMSORT_MIN_GALLOP || count2 >= TIMSORT_MIN_GALLOP );
+            if( done )
+                break;
+
+            if( minGallop < 0 )
+                minGallop = 0;
+            minGallop += 2;   // Penalize leaving gallop mode
+        }
+        if( minGallop < 1 )
+            minGallop = 1;
+
+        if( len2 == 1 )
+        {
+            dest -= len1;
+            cursor1 -= len1;
+            std::move_backward( a + cursor1 + 1, a + cursor1 + 1 + len1,
+                                a + dest + 1 + len1 );
+            a[ dest ] = std::move( tmp[ cursor2 ] );
+        }
+        else   // len1 == 0
+            std::move( tmp.begin( ), tmp.begin( ) + len2, a + dest - ( len2 - 1 ) );
+    }
+};
+
+/**
+ * #(This function is added)
+ * TimSort algorithm (driver): stable, adaptive natural mergesort.
+ * Linear time on sorted or reverse sorted input.
+ * #(first and last are added; sorts the items in [ first, last ))
+ * # @compare: less_than or greater_than, able to sort vector from smallest to largest
+ *				or from largest to smallest
+ */
+template <typename RandomIt, typename Comparator>
+void timSort( RandomIt first, RandomIt last, Comparator compare )
+{
+    auto a = arrayBegin( first );
+    TimSort<decltype( a ), Comparator>( a, checkedSize( first, last ), compare ).sort( );
+}
+
+template <typename Comparable, typename Comparator>
+void timSort( vector<Comparable> & a, Comparator compare )
+{
+    timSort( a.begin( ), a.end( ), compare );
+}
+
+template <typename Comparable, typename Comparator>
+void timSort( span<Comparable> a, Comparator compare )
+{
+    timSort( a.begin( ), a.end( ), compare );
+}
+
+/**
+ * Internal traits for radixSort and the network leaves of introsort.
+ * isStandard is true only for the standard comparators less and greater,
+ * whose order radixSort and networkSort can reproduce without calling
+ * compare; descending tells whether the keys go up (less) or down (greater).
+ */
+template <typename Comparator>
+struct StandardOrder
+{
+    static const bool isStandard = false;
+    static const bool descending = false;
+};
+
+template <typename T>
+struct StandardOrder< less<T> >
+{
+    static const bool isStandard = true;
+    static const bool descending = false;
+};
+
+template <typename T>
+struct StandardOrder< greater<T> >
+{
+    static const bool isStandard = true;
+    static const bool descending = true;
+};
+
+/**
+ * Internal method for radixSort.
+ * Maps x to an unsigned key with the same order: the sign bit of signed
+ * types is flipped, and every bit is flipped for descending order.
+ */
+template <typename Integer>
+typename make_unsigned<Integer>::type radixKey( Integer x, bool descending )
+{
+    typedef typename make_unsigned<Integer>::type Key;
+
+    Key key = static_cast<Key>( x );
+    if( is_signed<Integer>::value )
+        key ^= Key( Key( 1 ) << ( sizeof( Key ) * 8 - 1 ) );
+    return descending ? Key( ~key ) : key;
+}
+
+/**
+ * Internal radixSort method for the n integers starting at a.
+ * The scatter passes alternate between a and one buffer of the same size.
+ */
+template <typename Integer, typename Comparator>
+void radixSort( Integer *a, size_t n, Comparator compare )
+{
+    static_assert( is_integral<Integer>::value && !is_same<Integer, bool>::value,
+                   "radixSort needs integral keys" );
+    typedef typename make_unsigned<Integer>::type Key;
+
+    static_assert( StandardOrder<Comparator>::isStandard,
+                   "radixSort needs less<Integer> or greater<Integer>" );
+    const bool descending = StandardOrder<Comparator>::descending;
+    const int BITS = sizeof( Integer ) <= 2 ? 8 : 11;
+    const int BUCKETS = 1 << BITS;
+    const int PASSES = ( sizeof( Integer ) * 8 + BITS - 1 ) / BITS;
+    if( n < 2 )
+        return;
+
+        // Histograms of every digit in a single pass
+    vector<size_t> counts( PASSES * BUCKETS, 0 );
+    for( size_t i = 0; i < n; ++i )
+    {
+        Key key = radixKey( a[ i ], descending );
+        for( int p = 0; p < PASSES; ++p )
+            ++counts[ p * BUCKETS + ( ( key >> ( p * BITS ) ) & ( BUCKETS - 1 ) ) ];
+    }
+
+    vector<Integer> buffer( n );
+    Integer *from = a;
+    Integer *to = buffer.data( );
+    for( int p = 0; p < PASSES; ++p )
+    {
+        size_t *count = &counts[ p * BUCKETS ];
+        int shift = p * BITS;
+        if( count[ ( radixKey( from[ 0 ], descending ) >> shift ) & ( BUCKETS - 1 ) ] == n )
+            continue;    // All items share this digit
+
+        size_t sum = 0;  // Bucket starts
+        for( int b = 0; b < BUCKETS; ++b )
+        {
+            size_t c = count[ b ];
+            count[ b ] = sum;
+            sum += c;
+        }
+        for( size_t i = 0; i < n; ++i )
+            to[ count[ ( radixKey( from[ i ], descending ) >> shift ) & ( BUCKETS - 1 ) ]++ ] = from[ i ];
+        std::swap( from, to );
+    }
+
+    if( from != a )
+        std::copy( from, from + n, a );
+}
+
+/**
+ * #(This function is added)
+ * LSD radix sort for 8, 16, 32 and 64-bit integers.
+ * Uses 8-bit digits for 8 and 16-bit keys and 11-bit digits otherwise.
+ * One pass over the input builds the histograms of all digits, and a digit
+ * on which every item agrees is skipped. The scatter passes alternate
+ * between the items and one buffer of the same size; items behind a
+ * non-contiguous iterator are copied into a vector first.
+ * # @compare: less<Integer> or greater<Integer>, sorts smallest to largest
+ *				or largest to smallest
+ */
+template <typename RandomIt, typename Comparator>
+void radixSort( RandomIt first, RandomIt last, Comparator compare )
+{
+    typedef typename iterator_traits<RandomIt>::value_type Integer;
+
+    if constexpr( contiguous_iterator<RandomIt> )
+        radixSort( to_address( first ), size_t( last - first ), compare );
+    else
+    {
+        vector<Integer> items( first, last );
+        radixSort( items.data( ), items.size( ), compare );
+        std::copy( items.begin( ), items.end( ), first );
+    }
+}
+
+template <typename Integer, typename Comparator>
+void radixSort( vector<Integer> & a, Comparator compare )
+{
+    radixSort( a.begin( ), a.end( ), compare );
+}
+
+template <typename Integer, typename Comparator>
+void radixSort( span<Integer> a, Comparator compare )
+{
+    radixSort( a.begin( ), a.end( ), compare );
+}
+
+/**
+ * #(This function is added)
+ * Multikey quicksort for strings (StringSort.h), not stable.
+ * Strings sharing long prefixes are compared 7 bytes at a time through
+ * keys cached next to the string pointers, and large buckets are split
+ * by an MSD radix step.
+ * # @compare: less<string> or greater<string>, sorts smallest to largest
+ *				or largest to smallest
+ */
+template <typename RandomIt, typename Comparator>
+void stringSort( RandomIt first, RandomIt last, Comparator compare )
+{
+    static_assert( is_same<typename iterator_traits<RandomIt>::value_type, string>::value,
+                   "stringSort needs std::string items" );
+    static_assert( StandardOrder<Comparator>::isStandard,
+                   "stringSort needs less<string> or greater<string>" );
+    multikeySort( first, last, StandardOrder<Comparator>::descending );
+}
+
+template <typename Comparator>
+void stringSort( vector<string> & a, Comparator compare )
+{
+    stringSort( a.begin( ), a.end( ), compare );
+}
+
+template <typename Comparator>
+void stringSort( span<string> a, Comparator compare )
+{
+    stringSort( a.begin( ), a.end( ), compare );
+}
+
+/**
+ * #(This function is added)
+ * Stable merge sort for strings (StringSort.h) that keeps the longest
+ * common prefix of each item with its predecessor, so merging compares
+ * only past the prefix two runs are known to share.
+ * # @compare: less<string> or greater<string>, sorts smallest to largest
+ *				or largest to smallest
+ */
+template <typename RandomIt, typename Comparator>
+void stableStringSort( RandomIt first, RandomIt last, Comparator compare )
+{
+    static_assert( is_same<typename iterator_traits<RandomIt>::value_type, string>::value,
+                   "stableStringSort needs std::string items" );
+    static_assert( StandardOrder<Comparator>::isStandard,
+                   "stableStringSort needs less<string> or greater<string>" );
+    lcpMergeSort( first, last, StandardOrder<Comparator>::descending );
+}
+
+template <typename Comparator>
+void stableStringSort( vector<string> & a, Comparator compare )
+{
+    stableStringSort( a.begin( ), a.end( ), compare );
+}
+
+template <typename Comparator>
+void stableStringSort( span<string> a, Comparator compare )
+{
+    stableStringSort( a.begin( ), a.end( ), compare );
+}
+
+/**
+ * Return median of left, center, and right.
+ * Order these and hide the pivot.
+ * #(compare is added)
+ */
+template <typename RandomIt, typename Comparator>
+const typename iterator_traits<RandomIt>::value_type &
+median3( RandomIt a, int left, int right, Comparator compare)
+{
+    int center = ( left + right ) / 2;
+    
+    if( compare(a[ center ] , a[ left ] ))
+        swapItems( a[ left ], a[ center ], compare );
+    if( compare(a[ right ] , a[ left ] ))
+        swapItems( a[ left ], a[ right ], compare );
+    if( compare(a[ right ] , a[ center ] ))
+        swapItems( a[ center ], a[ right ], compare );
+
+        // Place pivot at position right - 1
+    swapItems( a[ center ], a[ right -1 ], compare );
+    return a[ right - 1 ];
+}
+
+/**
+ * Subarrays with at most this many items are finished by insertion sort.
+ */
+const int INSERTION_SORT_CUTOFF = 10;
+
+/**
+ * #(This function is added)
+ * Internal method for the tuned routines.
+ * Returns the entry of the host tuning profile (SortTuning.h) for sorting
+ * n Comparable items with compare, or nullptr when there is none: the
+ * type is not profiled, compare is not less or greater, or nothing was
+ * measured. Untuned types never look at the profile.
+ */
+template <typename Comparable, typename Comparator>
+const TuningEntry * findTuning( long long n )
+{
+    if constexpr( TuningType<Comparable>::index < 0 || !StandardOrder<Comparator>::isStandard )
+        return nullptr;
+    else
+    {
+        const TuningEntry & entry = sortTuningProfile( ).find( TuningType<Comparable>::index,
+                                                               StandardOrder<Comparator>::descending, n );
+        return entry.tuned( ) ? &entry : nullptr;
+    }
+}
+
+/**
+ * #(This function is added)
+ * Internal method for the quicksorts: the leaf cutoff of the tuning
+ * profile for n items, at most TUNING_MAX_CUTOFF, or defaultCutoff.
+ */
+template <typename Comparable, typename Comparator>
+int tunedCutoff( long long n, int defaultCutoff )
+{
+    const TuningEntry *entry = findTuning<Comparable, Comparator>( n );
+    return entry != nullptr ? min( entry->cutoff, TUNING_MAX_CUTOFF ) : defaultCutoff;
+}
+
+/**
+ * Internal leaf policy for introsort.
+ * Subarrays of at most cutoff( n ) items of an array of n items are
+ * finished by sort( ); the cutoff comes from the tuning profile when it
+ * has one. network( ) tells whether sort( ) uses a sorting network.
+ * The general case is insertion sort; contiguous integers of at most 32 bits
+ * and floats ordered by less or greater use a SIMD sorting network on 32-bit
+ * keys when the CPU has SSE4.1 or AVX2 (see NetworkKey in SortingNetworks.h).
+ * The other arithmetic types keep insertion sort: bool needs no network, and
+ * 64-bit items (int64_t, uint64_t, double, long double) have no SIMD network,
+ * since SSE4.1 and AVX2 lack 64-bit min/max. The scalar networks are not
+ * used here, they measured slower than insertion sort.
+ */
+template <typename RandomIt, typename Comparator,
+          bool Network = is_pointer<RandomIt>::value
+                         && NetworkKey<typename iterator_traits<RandomIt>::value_type>::value
+                         && StandardOrder<Comparator>::isStandard>
+struct SortLeaf
+{
+    typedef typename iterator_traits<RandomIt>::value_type Comparable;
+
+    static int cutoff( int n )
+    {
+        return tunedCutoff<Comparable, Comparator>( n, INSERTION_SORT_CUTOFF );
+    }
+
+    static bool network( )
+    {
+        return false;
+    }
+
+    static void sort( RandomIt a, int left, int right, Comparator compare )
+    {
+        insertionSort( a, left, right, compare );
+    }
+};
+
+template <typename RandomIt, typename Comparator>
+struct SortLeaf<RandomIt, Comparator, true>
+{
+    typedef typename iterator_traits<RandomIt>::value_type Comparable;
+
+    static int cutoff( int n )
+    {
+        if( networkIsa( ) == NETWORK_SCALAR )
+            return tunedCutoff<Comparable, Comparator>( n, INSERTION_SORT_CUTOFF );
+        return min( tunedCutoff<Comparable, Comparator>( n, networkLeafSize<Comparable>( ) ),
+                    networkLeafSize<Comparable>( ) );
+    }
+
+    static bool network( )
+    {
+        return networkIsa( ) != NETWORK_SCALAR;
+    }
+
+    static void sort( RandomIt a, int left, int right, Comparator compare )
+    {
+        if( networkIsa( ) == NETWORK_SCALAR )
+            insertionSort( a, left, right, compare );
+        else
+            networkSort( a + left, right - left + 1, StandardOrder<Comparator>::descending );
+    }
+};
+
+/**
+ * Subarrays with more than this many items use the ninther pivot,
+ * and get more pivot candidates shuffled after a bad partition.
+ */
+const int NINTHER_THRESHOLD = 128;
+
+/**
+ * Internal method for the pivot policies.
+ * Orders a[ i ], a[ j ] and a[ k ], so a[ j ] holds their median.
+ */
+template <typename RandomIt, typename Comparator>
+void sort3( RandomIt a, int i, int j, int k, Comparator compare )
+{
+    if( compare( a[ j ], a[ i ] ) )
+        swapItems( a[ i ], a[ j ], compare );
+    if( compare( a[ k ], a[ j ] ) )
+    {
+        swapItems( a[ j ], a[ k ], compare );
+        if( compare( a[ j ], a[ i ] ) )
+            swapItems( a[ i ], a[ j ], compare );
+    }
+}
+
+/**
+ * #(These pivot policies are added)
+ * Pivot policies for introsort.
+ * select( a, left, right, compare ) returns the index of the pivot
+ * of a[ left .. right ], and may reorder the candidates it looks at.
+ */
+
+/**
+ * Pivot is the first item (quicksortFirst).
+ */
+struct FirstPivot
+{
+    template <typename RandomIt, typename Comparator>
+    static int select( RandomIt a, int left, int right, Comparator compare )
+      { return left; }
+};
+
+/**
+ * Pivot is the middle item (quicksortMiddle).
+ */
+struct MiddlePivot
+{
+    template <typename RandomIt, typename Comparator>
+    static int select( RandomIt a, int left, int right, Comparator compare )
+      { return left + ( right - left ) / 2; }
+};
+
+/**
+ * Pivot is the median of the first, middle and last items (quicksort).
+ */
+struct MedianOfThreePivot
+{
+    template <typename RandomIt, typename Comparator>
+    static int select( RandomIt a, int left, int right, Comparator compare )
+    {
+        int center = left + ( right - left ) / 2;
+        sort3( a, left, center, right, compare );
+        return center;
+    }
+};
+
+/**
+ * Pivot is the median of three medians of three (Tukey's ninther)
+ * for large subarrays, and the median of three otherwise.
+ */
+struct NintherPivot
+{
+    template <typename RandomIt, typename Comparator>
+    static int select( RandomIt a, int left, int right, Comparator compare )
+    {
+        int center = left + ( right - left ) / 2;
+        if( right - left + 1 > NINTHER_THRESHOLD )
+        {
+            sort3( a, left, center, right, compare );
+            sort3( a, left + 1, center - 1, right - 1, compare );
+            sort3( a, left + 2, center + 1, right - 2, compare );
+            sort3( a, center - 1, center, center + 1, compare );
+        }
+        else
+            sort3( a, left, center, right, compare );
+        return center;
+    }
+};
+
+/**
+ * Internal partitioning method for introsort.
+ * The pivot is a[ left ]. Afterwards the items smaller than the pivot are
+ * on its left, and the others on its right.
+ * Returns the final position of the pivot. alreadyPartitioned is set when
+ * no item had to be swapped.
+ */
+template <typename RandomIt, typename Comparator>
+int partitionRight( RandomIt a, int left, int right, Comparator compare,
+                    bool & alreadyPartitioned )
+{
+    typedef typename iterator_traits<RandomIt>::value_type Comparable;
+
+    Comparable pivot = std::move( a[ left ] );
+
+        // first stops on an item >= pivot, last on an item < pivot
+    int first = left + 1;
+    while( first <= right && compare( a[ first ], pivot ) )
+        ++first;
+    int last = right;
+    while( last >= first && !compare( a[ last ], pivot ) )
+        --last;
+
+    alreadyPartitioned = first >= last;
+    while( first < last )
+    {
+        swapItems( a[ first ], a[ last ], compare );
+        while( compare( a[ ++first ], pivot ) ) { }
+        while( !compare( a[ --last ], pivot ) ) { }
+    }
+
+    int pivotPos = first - 1;  // Restore pivot
+    a[ left ] = std::move( a[ pivotPos ] );
+    a[ pivotPos ] = std::move( pivot );
+    return pivotPos;
+}
+
+/**
+ * Items looked at per block by partitionRightBlock.
+ * Offsets inside a block must fit in an unsigned char.
+ */
+const int PARTITION_BLOCK_SIZE = 64;
+
+/**
+ * Internal method for partitionRightBlock.
+ * Exchanges a[ first + offsetsLeft[ i ] ] and a[ last - offsetsRight[ i ] ]
+ * for i < num. When the counts differ the exchanges are chained through one
+ * temporary (a cyclic permutation) instead of using swaps.
+ */
+template <typename RandomIt, typename Comparator>
+void swapOffsets( RandomIt a, int first, int last,
+                  const unsigned char *offsetsLeft, const unsigned char *offsetsRight,
+                  int num, bool useSwaps, Comparator compare )
+{
+    typedef typename iterator_traits<RandomIt>::value_type Comparable;
+
+    if( useSwaps )
+    {
+        for( int i = 0; i < num; ++i )
+            swapItems( a[ first + offsetsLeft[ i ] ], a[ last - offsetsRight[ i ] ], compare );
+    }
+    else if( num > 0 )
+    {
+        int l = first + offsetsLeft[ 0 ];
+        int r = last - offsetsRight[ 0 ];
+        Comparable tmp = std::move( a[ l ] );
+        a[ l ] = std::move( a[ r ] );
+        for( int i = 1; i < num; ++i )
+        {
+            l = first + offsetsLeft[ i ];
+            a[ r ] = std::move( a[ l ] );
+            r = last - offsetsRight[ i ];
+            a[ l ] = std::move( a[ r ] );
+        }
+        a[ r ] = std::move( tmp );
+    }
+}
+
+/**
+ * Internal partitioning method for introsort (BlockQuicksort).
+ * Same contract as partitionRight, but the scans do not branch on the
+ * comparisons: each side records the offsets of misplaced items of a block
+ * of PARTITION_BLOCK_SIZE items into a small buffer (the comparison result
+ * only advances the buffer count), and the recorded items are then
+ * exchanged in bulk.
+ */
+template <typename RandomIt, typename Comparator>
+int partitionRightBlock( RandomIt a, int left, int right, Comparator compare,
+                         bool & alreadyPartitioned )
+{
+    typedef typename iterator_traits<RandomIt>::value_type Comparable;
+
+    Comparable pivot = std::move( a[ left ] );
+
+        // first stops on an item >= pivot, last on an item < pivot
+    int first = left + 1;
+    while( first <= right && compare( a[ first ], pivot ) )
+        ++first;
+    int last = right;
+    while( last >= first && !compare( a[ last ], pivot ) )
+        --last;
+
+    alreadyPartitioned = first >= last;
+    if( !alreadyPartitioned )
+    {
+        swapItems( a[ first ], a[ last ], compare );
+        ++first;     // The unknown items are now a[ first .. last - 1 ]
+
+        alignas( 64 ) unsigned char offsetsLeft[ PARTITION_BLOCK_SIZE ];
+        alignas( 64 ) unsigned char offsetsRight[ PARTITION_BLOCK_SIZE ];
+        int baseLeft = first, baseRight = last;
+        int numLeft = 0, numRight = 0, startLeft = 0, startRight = 0;
+
+        while( first < last )
+        {
+                // Refill the side(s) whose buffer is empty
+            int unknown = last - first;
+            int leftSplit = numLeft == 0 ? ( numRight == 0 ? unknown / 2 : unknown ) : 0;
+            int rightSplit = numRight == 0 ? unknown - leftSplit : 0;
+            leftSplit = min( leftSplit, PARTITION_BLOCK_SIZE );
+            rightSplit = min( rightSplit, PARTITION_BLOCK_SIZE );
+
+            for( int i = 0; i < leftSplit; ++i )
+            {
+                offsetsLeft[ numLeft ] = i;
+                numLeft += !compare( a[ first ], pivot );
+                ++first;
+            }
+            for( int i = 0; i < rightSplit; )
+            {
+                offsetsRight[ numRight ] = ++i;
+                numRight += compare( a[ --last ], pivot );
+            }
+
+            int num = min( numLeft, numRight );
+            swapOffsets( a, baseLeft, baseRight, offsetsLeft + startLeft, offsetsRight + startRight,
+                         num, numLeft == numRight, compare );
+            numLeft -= num;
+            numRight -= num;
+            startLeft += num;
+            startRight += num;
+            if( numLeft == 0 )
+            {
+                startLeft = 0;
+                baseLeft = first;
+            }
+            if( numRight == 0 )
+            {
+                startRight = 0;
+                baseRight = last;
+            }
+        }
+
+            // Move the misplaced items left in one buffer next to the boundary
+        if( numLeft != 0 )
+        {
+            while( numLeft-- )
+                swapItems( a[ baseLeft + offsetsLeft[ startLeft + numLeft ] ], a[ --last ], compare );
+            first = last;
+        }
+        if( numRight != 0 )
+        {
+            while( numRight-- )
+                swapItems( a[ baseRight - offsetsRight[ startRight + numRight ] ], a[ first++ ], compare );
+            last = first;
+        }
+    }
+
+    int pivotPos = first - 1;  // Restore pivot
+    a[ left ] = std::move( a[ pivotPos ] );
+    a[ pivotPos ] = std::move( pivot );
+    return pivotPos;
+}
+
+/**
+ * #(These partition schemes are added)
+ * Partition schemes for introsort.
+ * HoarePartition branches on every comparison, which is cheap for sorted
+ * input but mispredicts about half the time on random input.
+ * BlockPartition uses partitionRightBlock and does not branch on
+ * comparison results.
+ */
+struct HoarePartition
+{
+    template <typename RandomIt, typename Comparator>
+    static int partition( RandomIt a, int left, int right, Comparator compare,
+                          bool & alreadyPartitioned )
+      { return partitionRight( a, left, right, compare, alreadyPartitioned ); }
+};
+
+struct BlockPartition
+{
+    template <typename RandomIt, typename Comparator>
+    static int partition( RandomIt a, int left, int right, Comparator compare,
+                          bool & alreadyPartitioned )
+      { return partitionRightBlock( a, left, right, compare, alreadyPartitioned ); }
+};
+
+/**
+ * Internal partitioning method for introsort.
+ * The pivot is a[ left ]. Afterwards the items not greater than the pivot
+ * are on its left and the greater ones on its right.
+ * Used when the pivot equals the item just before the subarray: then
+ * every item on the left equals the pivot and is already in place.
+ * Returns the final position of the pivot.
+ */
+template <typename RandomIt, typename Comparator>
+int partitionLeft( RandomIt a, int left, int right, Comparator compare )
+{
+    typedef typename iterator_traits<RandomIt>::value_type Comparable;
+
+    Comparable pivot = std::move( a[ left ] );
+
+        // last stops on an item <= pivot, first on an item > pivot
+    int last = right;
+    while( last > left && compare( pivot, a[ last ] ) )
+        --last;
+    int first = left + 1;
+    while( first <= last && !compare( pivot, a[ first ] ) )
+        ++first;
+
+    while( first < last )
+    {
+        swapItems( a[ first ], a[ last ], compare );
+        while( compare( pivot, a[ --last ] ) ) { }
+        while( !compare( pivot, a[ ++first ] ) ) { }
+    }
+
+    int pivotPos = last;  // Restore pivot
+    a[ left ] = std::move( a[ pivotPos ] );
+    a[ pivotPos ] = std::move( pivot );
+    return pivotPos;
+}
+
+/**
+ * Internal method for introsort.
+ * Insertion sort that gives up after moving more than 8 items.
+ * Returns true if a[ left .. right ] is sorted, which takes linear time
+ * when the subarray was (nearly) sorted already.
+ */
+template <typename RandomIt, typename Comparator>
+bool partialInsertionSort( RandomIt a, int left, int right, Comparator compare )
+{
+    typedef typename iterator_traits<RandomIt>::value_type Comparable;
+
+    int moves = 0;
+    for( int p = left + 1; p <= right; ++p )
+    {
+        if( !compare( a[ p ], a[ p - 1 ] ) )
+            continue;
+
+        Comparable tmp = std::move( a[ p ] );
+        int j = p;
+        do
+        {
+            a[ j ] = std::move( a[ j - 1 ] );
+            --j;
+        } while( j > left && compare( tmp, a[ j - 1 ] ) );
+        a[ j ] = std::move( tmp );
+
+        moves += p - j;
+        if( moves > 8 )
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Internal method for introsort.
+ * Swaps a few items of a subarray left after a bad partition, so the
+ * next pivot comes from different candidates.
+ */
+template <typename RandomIt, typename Comparator>
+void shufflePivotCandidates( RandomIt a, int left, int right, Comparator compare )
+{
+    int size = right - left + 1;
+    if( size <= INSERTION_SORT_CUTOFF )
+        return;
+
+    int quarter = size / 4;
+    swapItems( a[ left ], a[ left + quarter ], compare );
+    swapItems( a[ right ], a[ right - quarter ], compare );
+    if( size > NINTHER_THRESHOLD )
+    {
+        swapItems( a[ left + 1 ], a[ left + quarter + 1 ], compare );
+        swapItems( a[ left + 2 ], a[ left + quarter + 2 ], compare );
+        swapItems( a[ right - 1 ], a[ right - quarter - 1 ], compare );
+        swapItems( a[ right - 2 ], a[ right - quarter - 2 ], compare );
+    }
+}
+
+/**
+ * Internal method: floor of log2( n ) for n > 0.
+ */
+inline int log2Floor( int n )
+{
+    int log = 0;
+    while( n >>= 1 )
+        ++log;
+    return log;
+}
+
+/**
+ * Internal introsort method: one partitioning step on a[ left .. right ]
+ * (at least 3 items), used by introsort and parallelQuicksort.
+ * Returns the final position of the pivot; a[ left .. pivot - 1 ] and
+ * a[ pivot + 1 .. right ] are then left to sort. When the pivot equals
+ * a[ left - 1 ] (not leftmost), the items equal to it are put in place
+ * and left is advanced to the pivot, so only the right side is left.
+ * Returns -1 when the step finished the subarray: it was (nearly)
+ * sorted, or badAllowed ran out and it was heapsorted.
+ * badAllowed is how many more unbalanced partitions (one side smaller
+ * than 1/8) are tolerated before the subarray is heapsorted.
+ * leftmost is false when a[ left - 1 ] is not greater than any item of
+ * the subarray.
+ */
+template <typename PivotPolicy, typename PartitionScheme, typename RandomIt, typename Comparator>
+int introsortStep( RandomIt a, int & left, int right, Comparator compare,
+                   int & badAllowed, bool leftmost )
+{
+    int size = right - left + 1;
+    swapItems( a[ left ], a[ PivotPolicy::select( a, left, right, compare ) ], compare );
+
+        // Pivot equals the item before the subarray: skip all copies of it
+    if( !leftmost && !compare( a[ left - 1 ], a[ left ] ) )
+    {
+        left = partitionLeft( a, left, right, compare );
+        return left;
+    }
+
+    bool alreadyPartitioned;
+    int pivotPos = PartitionScheme::partition( a, left, right, compare, alreadyPartitioned );
+    int leftSize = pivotPos - left;
+    int rightSize = right - pivotPos;
+    recordPartition( compare, leftSize, rightSize );
+
+        // Nearly sorted input finishes here in linear time
+    if( alreadyPartitioned
+        && partialInsertionSort( a, left, pivotPos - 1, compare )
+        && partialInsertionSort( a, pivotPos + 1, right, compare ) )
+        return -1;
+
+    if( leftSize < size / 8 || rightSize < size / 8 )
+    {
+        if( --badAllowed == 0 )
+        {
+            heapsort( a, left, right, compare );
+            return -1;
+        }
+        shufflePivotCandidates( a, left, pivotPos - 1, compare );
+        shufflePivotCandidates( a, pivotPos + 1, right, compare );
+    }
+    return pivotPos;
+}
+
+/**
+ * Internal introsort method that makes recursive calls
+ * (pattern-defeating quicksort).
+ * a is an array of Comparable items.
+ * left is the left-most index of the subarray.
+ * right is the right-most index of the subarray.
+ * badAllowed and leftmost are as in introsortStep.
+ * Subarrays of at most cutoff items are finished by the leaf policy.
+ * The smaller side is sorted recursively and the larger side by the loop,
+ * so the recursion depth stays below log2( n ).
+ */
+template <typename PivotPolicy, typename PartitionScheme, typename RandomIt, typename Comparator>
+void introsort( RandomIt a, int left, int right, Comparator compare,
+                int badAllowed, bool leftmost, int cutoff )
+{
+    typedef SortLeaf<RandomIt, Comparator> Leaf;
+    RecursionLevel<Comparator> level( compare );
+
+    while( right - left + 1 > cutoff )
+    {
+        int pivotPos = introsortStep<PivotPolicy, PartitionScheme>( a, left, right, compare,
+                                                                    badAllowed, leftmost );
+        if( pivotPos < 0 )
+            return;
+
+        if( pivotPos - left < right - pivotPos )
+        {
+            introsort<PivotPolicy, PartitionScheme>( a, left, pivotPos - 1, compare,
+                                                     badAllowed, leftmost, cutoff );
+            left = pivotPos + 1;
+            leftmost = false;
+        }
+        else
+        {
+            introsort<PivotPolicy, PartitionScheme>( a, pivotPos + 1, right, compare,
+                                                     badAllowed, false, cutoff );
+            right = pivotPos - 1;
+        }
+    }
+    if( left < right )
+        Leaf::sort( a, left, right, compare );
+}
+
+/**
+ * #(This function is added)
+ * Introsort of the subarray a[ left .. right ].
+ * Quicksort with the pivot chosen by PivotPolicy (FirstPivot, MiddlePivot,
+ * MedianOfThreePivot or NintherPivot), hardened against bad inputs:
+ * it falls back to heapsort after log2( n ) unbalanced partitions,
+ * finishes (nearly) sorted subarrays in linear time, and shuffles pivot
+ * candidates after an unbalanced partition.
+ * PartitionScheme is HoarePartition (default) or BlockPartition.
+ * # @compare: less_than or greater_than, able to sort smallest to largest
+ *				or largest to smallest
+ */
+template <typename PivotPolicy, typename PartitionScheme = HoarePartition,
+          typename RandomIt, typename Comparator>
+void introsort( RandomIt a, int left, int right, Comparator compare )
+{
+    int n = right - left + 1;
+    if( n > 1 )
+        introsort<PivotPolicy, PartitionScheme>( a, left, right, compare, log2Floor( n ) + 1, true,
+                                                 SortLeaf<RandomIt, Comparator>::cutoff( n ) );
+}
+
+template <typename PivotPolicy, typename PartitionScheme = HoarePartition,
+          typename Comparable, typename Comparator>
+void introsort( vector<Comparable> & a, int left, int right, Comparator compare )
+{
+    introsort<PivotPolicy, PartitionScheme>( a.data( ), left, right, compare );
+}
+
+/**
+ * #(This function is added)
+ * Introsort algorithm (driver).
+ * For example introsort<NintherPivot>( a, less<int>{ } ) or
+ * introsort<MedianOfThreePivot, BlockPartition>( a.begin( ), a.end( ), less<int>{ } ).
+ * # @compare: less_than or greater_than, able to sort smallest to largest
+ *				or largest to smallest
+ */
+template <typename PivotPolicy, typename PartitionScheme = HoarePartition,
+          typename RandomIt, typename Comparator>
+void introsort( RandomIt first, RandomIt last, Comparator compare )
+{
+    introsort<PivotPolicy, PartitionScheme>( arrayBegin( first ), 0, checkedSize( first, last ) - 1, compare );
+}
+
+template <typename PivotPolicy, typename PartitionScheme = HoarePartition,
+          typename Comparable, typename Comparator>
+void introsort( vector<Comparable> & a, Comparator compare )
+{
+    introsort<PivotPolicy, PartitionScheme>( a.begin( ), a.end( ), compare );
+}
+
+template <typename PivotPolicy, typename PartitionScheme = HoarePartition,
+          typename Comparable, typename Comparator>
+void introsort( span<Comparable> a, Comparator compare )
+{
+    introsort<PivotPolicy, PartitionScheme>( a.begin( ), a.end( ), compare );
+}
+
+/**
+ * #(This function is added (similar to quicksort))
+ * Internal quicksort method.
+ * Uses the first item as pivot; see introsort.
+ * a is an array of Comparable items.
+ * left is the left-most index of the subarray.
+ * right is the right-most index of the subarray.
+ * #(compare is added)
+ * # @compare: less_than or greater_than, able to sort smallest to largest
+ *				or largest to smallest
+ */
+template <typename RandomIt, typename Comparator>
+void quicksortFirst( RandomIt a, int left, int right, Comparator compare)
+{
+    introsort<FirstPivot>( a, left, right, compare );
+}
+
+template <typename Comparable, typename Comparator>
+void quicksortFirst( vector<Comparable> & a, int left, int right, Comparator compare)
+{
+    quicksortFirst( a.data( ), left, right, compare );
+}
+
+
+/**
+ * #(This function is added (similar to quicksort))
+ * Internal quicksort method.
+ * Uses the middle item as pivot; see introsort.
+ * a is an array of Comparable items.
+ * left is the left-most index of the subarray.
+ * right is the right-most index of the subarray.
+ * #(compare is added)
+ * # @compare: less_than or greater_than, able to sort smallest to largest
+ *				or largest to smallest
+ */
+template <typename RandomIt, typename Comparator>
+void quicksortMiddle( RandomIt a, int left, int right, Comparator compare)
+{
+    introsort<MiddlePivot>( a, left, right, compare );
+}
+
+template <typename Comparable, typename Comparator>
+void quicksortMiddle( vector<Comparable> & a, int left, int right, Comparator compare)
+{
+    quicksortMiddle( a.data( ), left, right, compare );
+}
+
+/**
+ * Internal quicksort method.
+ * Uses median-of-three partitioning and network or insertion sort leaves; see introsort.
+ * a is an array of Comparable items.
+ * left is the left-most index of the subarray.
+ * right is the right-most index of the subarray.
+ * #(compare is added)
+ * # @compare: less_than or greater_than, able to sort smallest to largest
+ *				or largest to smallest
+ */
+template <typename RandomIt, typename Comparator>
+void quicksort( RandomIt a, int left, int right, Comparator compare)
+{
+    introsort<MedianOfThreePivot>( a, left, right, compare );
+}
+
+template <typename Comparable, typename Comparator>
+void quicksort( vector<Comparable> & a, int left, int right, Comparator compare)
+{
+    quicksort( a.data( ), left, right, compare );
+}
+
+/**
+ * Quicksort algorithm (driver).
+ * #(compare is added)
+ * #(first and last are added; sorts the items in [ first, last ),
+ *   the vector and span versions sort all their items)
+ * #(items that IndirectSort selects are sorted through an array of
+ *   indexes and then moved once each)
+ * # @compare: less_than or greater_than, able to sort smallest to largest
+ *				or largest to smallest
+ */
+template <typename RandomIt, typename Comparator>
+void quicksort( RandomIt first, RandomIt last, Comparator compare )
+{
+    typedef typename iterator_traits<RandomIt>::value_type Comparable;
+    auto a = arrayBegin( first );
+    int n = checkedSize( first, last );
+    if constexpr( IndirectSort<Comparable>::quicksort )
+    {
+        vector<uint32_t> perm = identityPermutation<uint32_t>( n );
+        quicksort( perm.data( ), 0, n - 1, IndirectCompare<decltype( a ), Comparator>{ a, compare } );
+        applyPermutation( perm, a );
+    }
+    else
+        quicksort( a, 0, n - 1, compare );
+}
+
+template <typename Comparable, typename Comparator>
+void quicksort( vector<Comparable> & a, Comparator compare)
+{
+    quicksort( a.begin( ), a.end( ), compare );
+}
+
+template <typename Comparable, typename Comparator>
+void quicksort( span<Comparable> a, Comparator compare )
+{
+    quicksort( a.begin( ), a.end( ), compare );
+}
+
+/**
+ * #(This function is added)
+ * Quicksort algorithm with middle element of vector used as pivot
+ * #(compare is added)
+ * # @compare: less_than or greater_than, able to sort smallest to largest
+ *				or largest to smallest
+ */
+template <typename RandomIt, typename Comparator>
+void quicksortMiddle( RandomIt first, RandomIt last, Comparator compare )
+{
+    quicksortMiddle( arrayBegin( first ), 0, checkedSize( first, last ) - 1, compare );
+}
+
+template <typename Comparable, typename Comparator>
+void quicksortMiddle( vector<Comparable> & a, Comparator compare)
+{
+    quicksortMiddle( a.begin( ), a.end( ), compare );
+}
+
+template <typename Comparable, typename Comparator>
+void quicksortMiddle( span<Comparable> a, Comparator compare )
+{
+    quicksortMiddle( a.begin( ), a.end( ), compare );
+}
+
+/**
+ * #(This function is added)
+ * Quicksort algorithm with first element of vector used as pivot
+ * #(compare is added)
+ * # @compare: less_than or greater_than, able to sort smallest to largest
+ *				or largest to smallest
+ */
+template <typename RandomIt, typename Comparator>
+void quicksortFirst( RandomIt first, RandomIt last, Comparator compare )
+{
+    quicksortFirst( arrayBegin( first ), 0, checkedSize( first, last ) - 1, compare );
+}
+
+template <typename Comparable, typename Comparator>
+void quicksortFirst( vector<Comparable> & a, Comparator compare)
+{
+    quicksortFirst( a.begin( ), a.end( ), compare );
+}
+
+template <typename Comparable, typename Comparator>
+void quicksortFirst( span<Comparable> a, Comparator compare )
+{
+    quicksortFirst( a.begin( ), a.end( ), compare );
+}
+
+/**
+ * Projection that returns the item itself.
+ * The projection overloads of quicksort and mergeSort sort directly,
+ * without extracting keys, when given Identity.
+ */
+struct Identity
+{
+    template <typename T>
+    const T & operator()( const T & x ) const
+    {
+        return x;
+    }
+};
+
+/**
+ * Internal traits for the projection overloads.
+ * type is the key proj extracts from a Comparable, stored by value.
+ */
+template <typename Comparable, typename Projection>
+struct ProjectedKey
+{
+    typedef typename decay<decltype( declval<Projection &>( )( declval<const Comparable &>( ) ) )>::type type;
+};
+
+/**
+ * Internal comparator for the projection overloads.
+ * Compares ( key, index ) pairs by key only.
+ */
+template <typename Comparator>
+struct KeyIndexCompare
+{
+    Comparator compare;
+
+    template <typename Pair>
+    bool operator()( const Pair & lhs, const Pair & rhs ) const
+    {
+        return compare( lhs.first, rhs.first );
+    }
+};
+
+/**
+ * Internal method for the projection overloads (decorate).
+ * Extracts the key of each of the n items once, paired with its index.
+ */
+template <typename RandomIt, typename Projection>
+vector<pair<typename ProjectedKey<typename iterator_traits<RandomIt>::value_type, Projection>::type, int> >
+decorate( RandomIt a, int n, Projection proj )
+{
+    vector<pair<typename ProjectedKey<typename iterator_traits<RandomIt>::value_type, Projection>::type, int> > keyed;
+    keyed.reserve( n );
+    for( int i = 0; i < n; ++i )
+        keyed.push_back( make_pair( proj( a[ i ] ), i ) );
+    return keyed;
+}
+
+/**
+ * Internal method for the projection overloads (undecorate).
+ * Moves the items into the order of the sorted ( key, index ) pairs,
+ * each one once (applyPermutation).
+ */
+template <typename RandomIt, typename Keyed>
+void undecorate( RandomIt a, const Keyed & keyed )
+{
+    vector<uint32_t> perm( keyed.size( ) );
+    for( size_t i = 0; i < keyed.size( ); ++i )
+        perm[ i ] = keyed[ i ].second;
+    applyPermutation( perm, a );
+}
+/**
+ * #(This function is added)
+ * Quicksort by key: orders the items by compare( proj( x ), proj( y ) ).
+ * proj is called once per item; the ( key, index ) pairs are sorted and
+ * the items are then moved into place once (decorate-sort-undecorate).
+ * Identity sorts the items directly.
+ * # @compare: less_than or greater_than on the keys
+ */
+template <typename RandomIt, typename Comparator, typename Projection>
+void quicksort( RandomIt first, RandomIt last, Comparator compare, Projection proj )
+{
+    if constexpr( is_same<Projection, Identity>::value )
+        quicksort( first, last, compare );
+    else
+    {
+        auto a = arrayBegin( first );
+        auto keyed = decorate( a, checkedSize( first, last ), proj );
+        quicksort( keyed.begin( ), keyed.end( ), KeyIndexCompare<Comparator>{ compare } );
+        undecorate( a, keyed );
+    }
+}
+
+template <typename Comparable, typename Comparator, typename Projection>
+void quicksort( vector<Comparable> & a, Comparator compare, Projection proj )
+{
+    quicksort( a.begin( ), a.end( ), compare, proj );
+}
+
+template <typename Comparable, typename Comparator, typename Projection>
+void quicksort( span<Comparable> a, Comparator compare, Projection proj )
+{
+    quicksort( a.begin( ), a.end( ), compare, proj );
+}
+
+/**
+ * #(This function is added)
+ * Mergesort by key, stable: items with equal keys keep their order.
+ * proj is called once per item, see the projection overload of quicksort.
+ * # @compare: less_than or greater_than on the keys
+ */
+template <typename RandomIt, typename Comparator, typename Projection>
+void mergeSort( RandomIt first, RandomIt last, Comparator compare, Projection proj )
+{
+    if constexpr( is_same<Projection, Identity>::value )
+        mergeSort( first, last, compare );
+    else
+    {
+        auto a = arrayBegin( first );
+        auto keyed = decorate( a, checkedSize( first, last ), proj );
+        mergeSort( keyed.begin( ), keyed.end( ), KeyIndexCompare<Comparator>{ compare } );
+        undecorate( a, keyed );
+    }
+}
+
+template <typename Comparable, typename Comparator, typename Projection>
+void mergeSort( vector<Comparable> & a, Comparator compare, Projection proj )
+{
+    mergeSort( a.begin( ), a.end( ), compare, proj );
+}
+
+template <typename Comparable, typename Comparator, typename Projection>
+void mergeSort( span<Comparable> a, Comparator compare, Projection proj )
+{
+    mergeSort( a.begin( ), a.end( ), compare, proj );
+}
+
+
+/**
+ * #(This function is added)
+ * Argsort with quicksort: returns the permutation perm that sorts the
+ * items of [ first, last ), i.e. the item at sorted position i is
+ * first[ perm[ i ] ]. The items are not moved.
+ * Index is uint32_t by default, which halves the memory traffic of the
+ * permutation. Like quicksort it sorts at most INT_MAX items; more items,
+ * or more than Index can number, throw length_error.
+ * # @compare: less_than or greater_than, able to sort smallest to largest
+ *				or largest to smallest
+ */
+template <typename Index = uint32_t, typename RandomIt, typename Comparator>
+vector<Index> argQuicksort( RandomIt first, RandomIt last, Comparator compare )
+{
+    if( last - first > INT_MAX )
+        throw length_error( "argQuicksort: more than INT_MAX items" );
+    vector<Index> perm = identityPermutation<Index>( last - first );
+    auto a = arrayBegin( first );
+    quicksort( perm, IndirectCompare<decltype( a ), Comparator>{ a, compare } );
+    return perm;
+}
+
+template <typename Index = uint32_t, typename Comparable, typename Comparator>
+vector<Index> argQuicksort( const vector<Comparable> & a, Comparator compare )
+{
+    return argQuicksort<Index>( a.begin( ), a.end( ), compare );
+}
+
+template <typename Index = uint32_t, typename Comparable, typename Comparator>
+vector<Index> argQuicksort( span<Comparable> a, Comparator compare )
+{
+    return argQuicksort<Index>( a.begin( ), a.end( ), compare );
+}
+
+/**
+ * #(This function is added)
+ * Argsort with mergesort, stable: the indexes of equal items stay in
+ * increasing order. Like mergeSort it sorts at most INT_MAX items; see
+ * argQuicksort.
+ * # @compare: less_than or greater_than, able to sort smallest to largest
+ *				or largest to smallest
+ */
+template <typename Index = uint32_t, typename RandomIt, typename Comparator>
+vector<Index> argMergeSort( RandomIt first, RandomIt last, Comparator compare )
+{
+    if( last - first > INT_MAX )
+        throw length_error( "argMergeSort: more than INT_MAX items" );
+    vector<Index> perm = identityPermutation<Index>( last - first );
+    auto a = arrayBegin( first );
+    mergeSort( perm, IndirectCompare<decltype( a ), Comparator>{ a, compare } );
+    return perm;
+}
+
+template <typename Index = uint32_t, typename Comparable, typename Comparator>
+vector<Index> argMergeSort( const vector<Comparable> & a, Comparator compare )
+{
+    return argMergeSort<Index>( a.begin( ), a.end( ), compare );
+}
+
+template <typename Index = uint32_t, typename Comparable, typename Comparator>
+vector<Index> argMergeSort( span<Comparable> a, Comparator compare )
+{
+    return argMergeSort<Index>( a.begin( ), a.end( ), compare );
+}
+
+/**
+ * #(This function is added)
+ * Argsort with the LSD radix sort of radixSort, for integer items and
+ * less or greater; stable. Each pass moves the radix keys of the items
+ * together with their indexes, so the items are read only once.
+ * Any number of items: use uint64_t indexes for 2^32 items or more (more
+ * items than Index can number throw length_error).
+ * # @compare: less<Integer> or greater<Integer>
+ */
+template <typename Index = uint32_t, typename RandomIt, typename Comparator>
+vector<Index> argRadixSort( RandomIt first, RandomIt last, Comparator compare )
+{
+    typedef typename iterator_traits<RandomIt>::value_type Integer;
+    static_assert( is_integral<Integer>::value && !is_same<Integer, bool>::value,
+                   "argRadixSort needs integral keys" );
+    static_assert( StandardOrder<Comparator>::isStandard,
+                   "argRadixSort needs less<Integer> or greater<Integer>" );
+    typedef typename make_unsigned<Integer>::type Key;
+
+    const bool descending = StandardOrder<Comparator>::descending;
+    const int BITS = sizeof( Integer ) <= 2 ? 8 : 11;
+    const int BUCKETS = 1 << BITS;
+    const int PASSES = ( sizeof( Integer ) * 8 + BITS - 1 ) / BITS;
+    size_t n = last - first;
+    vector<Index> perm = identityPermutation<Index>( n );
+    if( n < 2 )
+        return perm;
+
+    vector<Key> keys( n );
+    vector<size_t> counts( PASSES * BUCKETS, 0 );
+    for( size_t i = 0; i < n; ++i )
+    {
+        keys[ i ] = radixKey( Integer( first[ i ] ), descending );
+        for( int p = 0; p < PASSES; ++p )
+            ++counts[ p * BUCKETS + ( ( keys[ i ] >> ( p * BITS ) ) & ( BUCKETS - 1 ) ) ];
+    }
+
+    vector<Key> keyBuffer( n );
+    vector<Index> permBuffer( n );
+    for( int p = 0; p < PASSES; ++p )
+    {
+        size_t *count = &counts[ p * BUCKETS ];
+        int shift = p * BITS;
+        if( count[ ( keys[ 0 ] >> shift ) & ( BUCKETS - 1 ) ] == n )
+            continue;    // All items share this digit
+
+        size_t sum = 0;  // Bucket starts
+        for( int b = 0; b < BUCKETS; ++b )
+        {
+            size_t c = count[ b ];
+            count[ b ] = sum;
+            sum += c;
+        }
+        for( size_t i = 0; i < n; ++i )
+        {
+            size_t to = count[ ( keys[ i ] >> shift ) & ( BUCKETS - 1 ) ]++;
+            keyBuffer[ to ] = keys[ i ];
+            permBuffer[ to ] = perm[ i ];
+        }
+        keys.swap( keyBuffer );
+        perm.swap( permBuffer );
+    }
+    return perm;
+}
+
+template <typename Index = uint32_t, typename Integer, typename Comparator>
+vector<Index> argRadixSort( const vector<Integer> & a, Comparator compare )
+{
+    return argRadixSort<Index>( a.begin( ), a.end( ), compare );
+}
+
+template <typename Index = uint32_t, typename Integer, typename Comparator>
+vector<Index> argRadixSort( span<Integer> a, Comparator compare )
+{
+    return argRadixSort<Index>( a.begin( ), a.end( ), compare );
+}
+
+
+/**
+ * Subarrays of at most this many items are finished by insertion sort
+ * in the selection methods.
+ */
+const int SELECT_CUTOFF = 16;
+
+/**
+ * Subarrays larger than this are narrowed by Floyd-Rivest sampling
+ * before they are partitioned.
+ */
+const int FLOYD_RIVEST_MIN = 600;
+
+/**
+ * #(This function is added)
+ * Internal method for the selection methods.
+ * Partitions a[ left .. right ] around the item at pivotIndex with the
+ * Hoare scans (which stop at items equal to the pivot, so runs of equal
+ * items are split evenly) and returns the final index of the pivot:
+ * the items before it do not come after it and the items after it do
+ * not come before it.
+ */
+template <typename RandomIt, typename Comparator>
+int selectPartition( RandomIt a, int left, int right, int pivotIndex, Comparator compare )
+{
+    typedef typename iterator_traits<RandomIt>::value_type Comparable;
+
+    Comparable pivot = a[ pivotIndex ];
+    swapItems( a[ left ], a[ pivotIndex ], compare );
+        // The pivot ends at one end and an item not before it at the
+        // other; they stop the scans on the first round
+    bool pivotAtLeft = compare( pivot, a[ right ] );
+    if( pivotAtLeft )
+        swapItems( a[ left ], a[ right ], compare );
+
+    int i = left, j = right;
+    while( i < j )
+    {
+        swapItems( a[ i ], a[ j ], compare );
+        ++i;
+        --j;
+        while( compare( a[ i ], pivot ) )
+            ++i;
+        while( compare( pivot, a[ j ] ) )
+            --j;
+    }
+    if( pivotAtLeft )
+        swapItems( a[ left ], a[ j ], compare );
+    else
+        swapItems( a[ ++j ], a[ right ], compare );
+    return j;
+}
+
+/**
+ * #(This function is added)
+ * Internal method for the selection methods.
+ * Median-of-medians selection: places the item of index nth of the
+ * sorted a[ left .. right ] at a[ nth ], smaller items before it and
+ * larger ones after it. The pivot is the median of the medians of groups
+ * of 5 items, which bounds each side of the partition by 7/10 of the
+ * subarray: linear time in the worst case.
+ */
+template <typename RandomIt, typename Comparator>
+void medianOfMediansSelect( RandomIt a, int left, int right, int nth, Comparator compare )
+{
+    RecursionLevel<Comparator> level( compare );
+    while( right - left >= SELECT_CUTOFF )
+    {
+            // Move the median of every group of 5 to the front
+        int medians = left;
+        for( int group = left; group <= right; group += 5 )
+        {
+            int last = min( group + 4, right );
+            insertionSort( a, group, last, compare );
+            swapItems( a[ medians++ ], a[ ( group + last ) / 2 ], compare );
+        }
+        int middle = left + ( medians - 1 - left ) / 2;
+        medianOfMediansSelect( a, left, medians - 1, middle, compare );
+
+        int p = selectPartition( a, left, right, middle, compare );
+        recordPartition( compare, p - left, right - p );
+        if( p == nth )
+            return;
+        if( nth < p )
+            right = p - 1;
+        else
+            left = p + 1;
+    }
+    insertionSort( a, left, right, compare );
+}
+
+/**
+ * #(This function is added)
+ * Internal method for the selection methods (introselect).
+ * Places the item of index nth of the sorted a[ left .. right ] at
+ * a[ nth ], smaller items before it and larger ones after it.
+ * Large subarrays are first narrowed by Floyd-Rivest sampling: the
+ * selection recurses on a small sample around the expected position of
+ * the nth item, which makes it an almost exact pivot, so about
+ * n + min( k, n - k ) comparisons are made on average. After depthLimit
+ * partitions it switches to median-of-medians selection, which is
+ * linear in the worst case.
+ */
+template <typename RandomIt, typename Comparator>
+void floydRivestSelect( RandomIt a, int left, int right, int nth, Comparator compare, int depthLimit )
+{
+    RecursionLevel<Comparator> level( compare );
+    while( right - left >= SELECT_CUTOFF )
+    {
+        if( depthLimit-- == 0 )
+        {
+            medianOfMediansSelect( a, left, right, nth, compare );
+            return;
+        }
+
+        int pivot;
+        if( right - left > FLOYD_RIVEST_MIN )
+        {
+                // Sample bounds of Floyd and Rivest (1975)
+            double n = right - left + 1;
+            double i = nth - left + 1;
+            double z = log( n );
+            double s = 0.5 * exp( 2 * z / 3 );
+            double sd = 0.5 * sqrt( z * s * ( n - s ) / n ) * ( i < n / 2 ? -1 : 1 );
+            int sampleLeft = max( left, int( nth - i * s / n + sd ) );
+            int sampleRight = min( right, int( nth + ( n - i ) * s / n + sd ) );
+            floydRivestSelect( a, sampleLeft, sampleRight, nth, compare, depthLimit );
+            pivot = nth;
+        }
+        else
+        {
+            median3( a, left, right, compare );
+            pivot = right - 1;
+        }
+
+        int p = selectPartition( a, left, right, pivot, compare );
+        recordPartition( compare, p - left, right - p );
+        if( p == nth )
+            return;
+        if( nth < p )
+            right = p - 1;
+        else
+            left = p + 1;
+    }
+    insertionSort( a, left, right, compare );
+}
+
+/**
+ * #(This function is added)
+ * Internal method for the selection methods.
+ * Places the item of index nth of the sorted a[ left .. right ] at
+ * a[ nth ], with a depth limit of 2 log2( n ) partitions.
+ */
+template <typename RandomIt, typename Comparator>
+void introSelect( RandomIt a, int left, int right, int nth, Comparator compare )
+{
+    if( left < right )
+        floydRivestSelect( a, left, right, nth, compare, 2 * log2Floor( right - left + 1 ) );
+}
+
+/**
+ * Internal selection method.
+ * Places the kth smallest item in a[k-1].
+ * a is an array of Comparable items.
+ * left is the left-most index of the subarray.
+ * right is the right-most index of the subarray.
+ * k is the desired rank (1 is minimum) in the entire array.
+ * #(compare is added)
+ * #(introselect: Floyd-Rivest sampling, median-of-medians after too many
+ *   partitions; it used to be quickselect with median-of-three pivots)
+ */
+template <typename RandomIt, typename Comparator>
+void quickSelect( RandomIt a, int left, int right, int k, Comparator compare )
+{
+    introSelect( a, left, right, k - 1, compare );
+}
+
+template <typename Comparable>
+void quickSelect( vector<Comparable> & a, int left, int right, int k )
+{
+    quickSelect( a.data( ), left, right, k, less<Comparable>{ } );
+}
+
+/**
+ * Quick selection algorithm.
+ * Places the kth smallest item in a[k-1].
+ * a is an array of Comparable items.
+ * k is the desired rank (1 is minimum) in the entire array.
+ * #(first and last are added; selects among the items in [ first, last ))
+ * #(compare is added; the versions without it use less)
+ * # @compare: less_than or greater_than, the kth smallest or the kth largest
  */
+template <typename RandomIt, typename Comparator>
+void quickSelect( RandomIt first, RandomIt last, int k, Comparator compare )
+{
+    quickSelect( arrayBegin( first ), 0, checkedSize( first, last ) - 1, k, compare );
+}
+
+template <typename Comparable, typename Comparator>
+void quickSelect( vector<Comparable> & a, int k, Comparator compare )
+{
+    quickSelect( a.begin( ), a.end( ), k, compare );
+}
+
+template <typename Comparable, typename Comparator>
+void quickSelect( span<Comparable> a, int k, Comparator compare )
+{
+    quickSelect( a.begin( ), a.end( ), k, compare );
+}
+
+template <typename RandomIt>
+void quickSelect( RandomIt first, RandomIt last, int k )
+{
+    typedef typename iterator_traits<RandomIt>::value_type Comparable;
+    quickSelect( first, last, k, less<Comparable>{ } );
+}
+
 template <typename Comparable>
-const Comparable & middle( vector<Comparable> & a, int left, int right)
+void quickSelect( vector<Comparable> & a, int k )
 {
-	int center = ( left + right ) / 2;
-	std::swap( a[ center ], a[ right - 1 ] );
-    return a[ right - 1 ];
-	
+    quickSelect( a.begin( ), a.end( ), k );
 }
 
-/**
- * #(This function is added)
- * Set the first element of vector a as new pivot
- * Swap pivot and the last element 
- * @Return pivot
- */
 template <typename Comparable>
-const Comparable & first( vector<Comparable> & a, int left, int right)
+void quickSelect( span<Comparable> a, int k )
 {
-	std::swap( a[ left+1 ], a[ right-1 ] );
-    return a[ right-1];
+    quickSelect( a.begin( ), a.end( ), k );
 }
 
 /**
- * Return median of left, center, and right.
- * Order these and hide the pivot.
- * #(compare is added)
+ * #(This function is added)
+ * Partial sort: moves the k smallest items (for compare) to the front,
+ * in order; the order of the other items is unspecified.
+ * Selects the kth item and sorts the k items before it, so it takes
+ * O( n + k log k ) time. k larger than the number of items sorts them all.
+ * # @compare: less_than or greater_than, the k smallest or the k largest
  */
+template <typename RandomIt, typename Comparator>
+void partialSort( RandomIt first, RandomIt last, int k, Comparator compare )
+{
+    auto a = arrayBegin( first );
+    int n = checkedSize( first, last );
+    k = min( k, n );
+    if( k <= 0 )
+        return;
+    introSelect( a, 0, n - 1, k - 1, compare );
+    quicksort( a, 0, k - 2, compare );
+}
+
 template <typename Comparable, typename Comparator>
-const Comparable & median3( vector<Comparable> & a, int left, int right, Comparator compare)
+void partialSort( vector<Comparable> & a, int k, Comparator compare )
 {
-    int center = ( left + right ) / 2;
-    
-    if( compare(a[ center ] , a[ left ] ))
-        std::swap( a[ left ], a[ center ] );
-    if( compare(a[ right ] , a[ left ] ))
-        std::swap( a[ left ], a[ right ] );
-    if( compare(a[ right ] , a[ center ] ))
-        std::swap( a[ center ], a[ right ] );
+    partialSort( a.begin( ), a.end( ), k, compare );
+}
 
-        // Place pivot at position right - 1
-    std::swap( a[ center ], a[ right -1 ] );
-    return a[ right - 1 ];
+template <typename Comparable, typename Comparator>
+void partialSort( span<Comparable> a, int k, Comparator compare )
+{
+    partialSort( a.begin( ), a.end( ), k, compare );
 }
 
 /**
- * #(This function is added (similar to quicksort))
- * Internal quicksort method that makes recursive calls.
- * Uses median-of-three partitioning and a cutoff of 10.
- * a is an array of Comparable items.
- * left is the left-most index of the subarray.
- * right is the right-most index of the subarray.
- * #(compare is added)
- * # @compare: less_than or greater_than, able to sort smallest to largest
- *				or largest to smallest
+ * Internal method for multiSelect.
+ * indexes[ firstRank .. lastRank ] are sorted indexes inside a[ left .. right ].
+ * Selects the middle one, then recurses on the ranks and items on each side.
  */
-template <typename Comparable, typename Comparator>
-void quicksortFirst( vector<Comparable> & a, int left, int right, Comparator compare)
+template <typename RandomIt, typename Comparator>
+void multiSelect( RandomIt a, int left, int right, const vector<int> & indexes,
+                  int firstRank, int lastRank, Comparator compare )
 {
-    if( left + 10 <= right )
-    {
-		const Comparable & pivot = first(a, left, right);
-        int i = left, j = right - 1;
-        for( ; ; )
-        {
-            while( compare(a[ ++i ] , pivot )) { }
-            while( compare(pivot , a[ --j ] )) { }
-            if( i < j )
-                std::swap( a[ i ], a[ j ] );
-            else
-                break;
-        }
-        std::swap( a[ i ], a[ right - 1 ] );  // Restore pivot
+    if( firstRank > lastRank )
+        return;
+    RecursionLevel<Comparator> level( compare );
+    int middleRank = ( firstRank + lastRank ) / 2;
+    int nth = indexes[ middleRank ];
+    introSelect( a, left, right, nth, compare );
+    multiSelect( a, left, nth - 1, indexes, firstRank, middleRank - 1, compare );
+    multiSelect( a, nth + 1, right, indexes, middleRank + 1, lastRank, compare );
+}
 
-        quicksortFirst( a, left, i - 1, compare);     // Sort left side of pivot
-        quicksortFirst( a, i + 1, right, compare);    // Sort right side of pivot
-    }
-    else  // Do an insertion sort on the subarray
-        insertionSort( a, left, right, compare);
+/**
+ * #(This function is added)
+ * Selects several ranks at once: places the kth smallest item in a[k-1]
+ * for every k in ranks (1 is minimum, any order, repeats allowed;
+ * ranks outside 1 .. n are ignored).
+ * Each selection only searches between the ranks already placed, so m
+ * ranks take O( n log m ) time instead of m full selections; e.g. the
+ * p50, p90, p99 and p99.9 of a latency array in one call.
+ * # @compare: less_than or greater_than, ranks from the smallest or the largest
+ */
+template <typename RandomIt, typename Comparator>
+void multiSelect( RandomIt first, RandomIt last, const vector<int> & ranks, Comparator compare )
+{
+    int n = checkedSize( first, last );
+    vector<int> indexes;
+    for( int rank : ranks )
+        if( rank >= 1 && rank <= n )
+            indexes.push_back( rank - 1 );
+    std::sort( indexes.begin( ), indexes.end( ) );
+    indexes.erase( std::unique( indexes.begin( ), indexes.end( ) ), indexes.end( ) );
+    multiSelect( arrayBegin( first ), 0, n - 1, indexes, 0, int( indexes.size( ) ) - 1, compare );
+}
+
+template <typename Comparable, typename Comparator>
+void multiSelect( vector<Comparable> & a, const vector<int> & ranks, Comparator compare )
+{
+    multiSelect( a.begin( ), a.end( ), ranks, compare );
 }
 
+template <typename Comparable, typename Comparator>
+void multiSelect( span<Comparable> a, const vector<int> & ranks, Comparator compare )
+{
+    multiSelect( a.begin( ), a.end( ), ranks, compare );
+}
 
 /**
- * #(This function is added (similar to quicksort))
- * Internal quicksort method that makes recursive calls.
- * Uses median-of-three partitioning and a cutoff of 10.
- * a is an array of Comparable items.
- * left is the left-most index of the subarray.
- * right is the right-most index of the subarray.
- * #(compare is added)
- * # @compare: less_than or greater_than, able to sort smallest to largest
- *				or largest to smallest
+ * #(This function is added)
+ * Internal method for SORT: Bentley-McIlroy three-way partitioning.
+ * The pivot is a[ left ]. The scans move the items equal to the pivot to
+ * both ends of the subarray as they meet them, and the two blocks of
+ * equal items are swapped into the middle at the end. Afterwards
+ * a[ left .. lt ] is smaller than the pivot, a[ lt + 1 .. gt - 1 ] is
+ * equal to it and a[ gt .. right ] is larger; nothing is allocated.
  */
-template <typename Comparable, typename Comparator>
-void quicksortMiddle( vector<Comparable> & a, int left, int right, Comparator compare)
+template <typename RandomIt, typename Comparator>
+void partition3Way( RandomIt a, int left, int right, Comparator compare, int & lt, int & gt )
 {
-    if( left + 10 <= right )
+    const auto & pivot = a[ left ];   // Not moved until the final swaps
+    int i = left, j = right + 1;
+    int p = left, q = right + 1;      // a[ left .. p ] and a[ q .. right ] equal the pivot
+
+    for( ; ; )
     {
-		const Comparable & pivot = middle(a, left, right);
-        // Begin partitioning
-        int i = left, j = right - 1;
-        for( ; ; )
-        {
-            while( compare(a[ ++i ] , pivot )) { }
-            while( compare(pivot , a[ --j ] )) { }
-            if( i < j )
-                std::swap( a[ i ], a[ j ] );
-            else
+        while( compare( a[ ++i ], pivot ) )
+            if( i == right )
                 break;
-        }
-        std::swap( a[ i ], a[ right - 1 ] );  // Restore pivot
-
-        quicksortMiddle( a, left, i - 1, compare);     // Sort left side of pivot
-        quicksortMiddle( a, i + 1, right, compare);    // Sort right side of pivot
+        while( compare( pivot, a[ --j ] ) )
+            if( j == left )
+                break;
+        if( i == j && !compare( a[ i ], pivot ) && !compare( pivot, a[ i ] ) )
+            swapItems( a[ ++p ], a[ i ], compare );
+        if( i >= j )
+            break;
+        swapItems( a[ i ], a[ j ], compare );
+            // a[ i ] is not larger than the pivot, a[ j ] is not smaller
+        if( !compare( a[ i ], pivot ) )
+            swapItems( a[ ++p ], a[ i ], compare );
+        if( !compare( pivot, a[ j ] ) )
+            swapItems( a[ --q ], a[ j ], compare );
     }
-    else  // Do an insertion sort on the subarray
-        insertionSort( a, left, right, compare);
+
+    i = j + 1;
+    for( int k = p; k >= left; --k )  // Equal items to the middle
+        swapItems( a[ k ], a[ j-- ], compare );
+    for( int k = q; k <= right; ++k )
+        swapItems( a[ k ], a[ i++ ], compare );
+    lt = j;
+    gt = i;
 }
 
 /**
- * Internal quicksort method that makes recursive calls.
- * Uses median-of-three partitioning and a cutoff of 10.
- * a is an array of Comparable items.
- * left is the left-most index of the subarray.
- * right is the right-most index of the subarray.
- * #(compare is added)
- * # @compare: less_than or greater_than, able to sort smallest to largest
- *				or largest to smallest
+ * #(This function is added)
+ * Internal method for SORT: three-way quicksort of a[ left .. right ].
+ * Ninther pivots, insertion sort for subarrays of at most cutoff items
+ * and heapsort after depthLimit partitions, as in introsort. Recurses on the smaller side
+ * and loops on the larger one, so the stack stays O( log n ).
  */
-template <typename Comparable, typename Comparator>
-void quicksort( vector<Comparable> & a, int left, int right, Comparator compare)
+template <typename RandomIt, typename Comparator>
+void quicksort3Way( RandomIt a, int left, int right, Comparator compare, int depthLimit, int cutoff )
 {
-	
-    if( left + 10 <= right )
+    RecursionLevel<Comparator> level( compare );
+    while( left + cutoff <= right )
     {
-		const Comparable & pivot = median3( a, left, right, compare);
-            // Begin partitioning
-        int i = left, j = right - 1;
-        for( ; ; )
+        if( depthLimit-- == 0 )
         {
-            while( compare(a[ ++i ] , pivot )) { }
-            while( compare(pivot , a[ --j ] )) { }
-            if( i <j )
-                std::swap( a[ i ], a[ j ] );
-            else
-                break;
+            heapsort( a, left, right, compare );
+            return;
+        }
+        swapItems( a[ left ], a[ NintherPivot::select( a, left, right, compare ) ], compare );
+
+        int lt, gt;
+        partition3Way( a, left, right, compare, lt, gt );
+        recordPartition( compare, lt - left + 1, right - gt + 1 );
+        if( lt - left < right - gt )
+        {
+            quicksort3Way( a, left, lt, compare, depthLimit, cutoff );
+            left = gt;
+        }
+        else
+        {
+            quicksort3Way( a, gt, right, compare, depthLimit, cutoff );
+            right = lt;
         }
-        std::swap( a[ i ], a[ right - 1 ] );  // Restore pivot
-        quicksort( a, left, i - 1, compare);     // Sort left side of pivot
-        quicksort( a, i + 1, right, compare);    // Sort right side of pivot
     }
-    else  // Do an insertion sort on the subarray
-        insertionSort( a, left, right, compare);
+    insertionSort( a, left, right, compare );
 }
 
 /**
- * Quicksort algorithm (driver).
- * #(compare is added)
- * # @compare: less_than or greater_than, able to sort smallest to largest
- *				or largest to smallest
+ * Three-way quicksort (driver).
+ * #(It used to move the items into new smaller, same and larger vectors
+ *   at every level; it now partitions in place)
+ * Every partition groups all the items equal to the pivot and leaves
+ * them out of the recursion, so an input with d distinct keys takes
+ * O( n log d ) time: linear when d is constant.
+ * #(compare is added; the version without it uses less)
+ * #(first and last are added; sorts the items in [ first, last ),
+ *   the vector and span versions sort all their items)
+ * # @compare: less_than or greater_than, able to sort vector from smallest to largest
+ *				or from largest to smallest
  */
+template <typename RandomIt, typename Comparator>
+void SORT( RandomIt first, RandomIt last, Comparator compare )
+{
+    typedef typename iterator_traits<RandomIt>::value_type Comparable;
+
+    int n = checkedSize( first, last );
+    if( n > 1 )
+        quicksort3Way( arrayBegin( first ), 0, n - 1, compare, 2 * log2Floor( n ),
+                       tunedCutoff<Comparable, Comparator>( n, INSERTION_SORT_CUTOFF ) );
+}
+
 template <typename Comparable, typename Comparator>
-void quicksort( vector<Comparable> & a, Comparator compare)
+void SORT( vector<Comparable> & items, Comparator compare )
+{
+    SORT( items.begin( ), items.end( ), compare );
+}
+
+template <typename Comparable, typename Comparator>
+void SORT( span<Comparable> items, Comparator compare )
 {
-    quicksort( a, 0, a.size( ) - 1, compare);
+    SORT( items.begin( ), items.end( ), compare );
+}
+
+template <typename Comparable>
+void SORT( vector<Comparable> & items )
+{
+    SORT( items.begin( ), items.end( ), less<Comparable>{ } );
 }
 
 /**
  * #(This function is added)
- * Quicksort algorithm with middle element of vector used as pivot
- * #(compare is added)
+ * Sorts with the algorithm the host tuning profile (SortTuning.h, written
+ * by tune_sorting) measured fastest for the type, order and size: one of
+ * quicksort, mergeSort, heapsort, SORT and timSort. Without a profile
+ * entry it is quicksort. Not stable (the choice may not be).
  * # @compare: less_than or greater_than, able to sort smallest to largest
  *				or largest to smallest
  */
+template <typename RandomIt, typename Comparator>
+void tunedSort( RandomIt first, RandomIt last, Comparator compare )
+{
+    typedef typename iterator_traits<RandomIt>::value_type Comparable;
+
+    const TuningEntry *entry = findTuning<Comparable, Comparator>( last - first );
+    switch( entry != nullptr ? entry->algorithm : TUNED_QUICKSORT )
+    {
+      case TUNED_MERGE_SORT:
+        mergeSort( first, last, compare );
+        break;
+      case TUNED_HEAPSORT:
+        heapsort( first, last, compare );
+        break;
+      case TUNED_THREE_WAY_QUICKSORT:
+        SORT( first, last, compare );
+        break;
+      case TUNED_TIMSORT:
+        timSort( first, last, compare );
+        break;
+      default:
+        quicksort( first, last, compare );
+        break;
+    }
+}
+
 template <typename Comparable, typename Comparator>
-void quicksortMiddle( vector<Comparable> & a, Comparator compare)
+void tunedSort( vector<Comparable> & a, Comparator compare )
+{
+    tunedSort( a.begin( ), a.end( ), compare );
+}
+
+template <typename Comparable, typename Comparator>
+void tunedSort( span<Comparable> a, Comparator compare )
 {
-    quicksortMiddle( a, 0, a.size( ) - 1, compare);
+    tunedSort( a.begin( ), a.end( ), compare );
 }
 
 /**
- * #(This function is added)
- * Quicksort algorithm with first element of vector used as pivot
- * #(compare is added)
- * # @compare: less_than or greater_than, able to sort smallest to largest
- *				or largest to smallest
+ * #(This section is added)
+ * The engines dispatchSort and dispatchStableSort choose from; both return
+ * the one that ran.
  */
-template <typename Comparable, typename Comparator>
-void quicksortFirst( vector<Comparable> & a, Comparator compare)
+enum SortEngine
+{
+    SORT_ENGINE_SORTED,                // Already in order: nothing moved
+    SORT_ENGINE_REVERSED,              // In reverse order: reversed
+    SORT_ENGINE_NETWORK,               // Tiny array: SIMD sorting network
+    SORT_ENGINE_INSERTION_SORT,        // Tiny array
+    SORT_ENGINE_TIMSORT,               // A few presorted runs, or the tuned choice
+    SORT_ENGINE_RADIX_SORT,            // Integer keys ordered by less or greater
+    SORT_ENGINE_STRING_SORT,           // Strings ordered by less or greater (stringSort)
+    SORT_ENGINE_STABLE_STRING_SORT,    // The same (stableStringSort)
+    SORT_ENGINE_BLOCK_QUICKSORT,       // Small trivially copyable items
+    SORT_ENGINE_QUICKSORT,
+    SORT_ENGINE_THREE_WAY_QUICKSORT,   // The tuned choice (SORT)
+    SORT_ENGINE_HEAPSORT,              // The tuned choice
+    SORT_ENGINE_MERGE_SORT,
+    SORT_ENGINE_COUNT
+};
+
+inline const char *sortEngineName( SortEngine engine )
 {
-    quicksortFirst( a, 0, a.size( ) - 1, compare);
+    static const char *names[ SORT_ENGINE_COUNT ] =
+        { "sorted", "reversed", "network", "insertionSort", "timSort", "radixSort",
+          "stringSort", "stableStringSort",
+          "block quicksort", "quicksort", "SORT", "heapsort", "mergeSort" };
+    return names[ engine ];
 }
 
 /**
- * Internal selection method that makes recursive calls.
- * Uses median-of-three partitioning and a cutoff of 10.
- * Places the kth smallest item in a[k-1].
- * a is an array of Comparable items.
- * left is the left-most index of the subarray.
- * right is the right-most index of the subarray.
- * k is the desired rank (1 is minimum) in the entire array.
+ * dispatchStableSort finishes arrays of at most this many items by
+ * insertion sort.
  */
-template <typename Comparable>
-void quickSelect( vector<Comparable> & a, int left, int right, int k )
+const int SMALL_SORT_MAX = 16;
+
+/**
+ * Arrays of integers (strings) with at least this many items are radix
+ * sorted (multikey sorted); the buffers do not pay off for fewer.
+ */
+const int RADIX_SORT_MIN_SIZE = 256;
+
+/**
+ * An array with no more than one run per this many items is "a few runs"
+ * and goes to timSort.
+ */
+const int FEW_RUNS_RATIO = 256;
+
+/**
+ * Internal class for dispatchSort and dispatchStableSort: what one pass
+ * over the array tells about its order. complete is false when the pass
+ * stopped early.
+ */
+struct Presortedness
+{
+    int descents = 0;    // a[ i ] before a[ i - 1 ]
+    int ascents = 0;     // a[ i - 1 ] before a[ i ]
+    int equal = 0;       // Neither
+    bool complete = true;
+};
+
+/**
+ * Internal method for dispatchSort and dispatchStableSort.
+ * Counts the descents, ascents and equal neighbours of a[ 0 .. n - 1 ],
+ * stopping as soon as there are more than limit of both, so an array
+ * without long runs costs a few comparisons per limit.
+ */
+template <typename RandomIt, typename Comparator>
+Presortedness measurePresortedness( RandomIt a, int n, Comparator compare, int limit )
 {
-    if( left + 10 <= right )
+    Presortedness order;
+    for( int i = 1; i < n; ++i )
     {
-        const Comparable & pivot = median3( a, left, right );
-            // Begin partitioning
-        int i = left, j = right - 1;
-        for( ; ; )
+        if( compare( a[ i ], a[ i - 1 ] ) )
+            ++order.descents;
+        else if( compare( a[ i - 1 ], a[ i ] ) )
+            ++order.ascents;
+        else
+            ++order.equal;
+        if( order.descents > limit && order.ascents > limit )
         {
-            while( a[ ++i ] < pivot ) { }
-            while( pivot < a[ --j ] ) { }
-            if( i < j )
-                std::swap( a[ i ], a[ j ] );
-            else
-                break;
+            order.complete = false;
+            break;
         }
-        std::swap( a[ i ], a[ right - 1 ] );  // Restore pivot
-            // Recurse; only this part changes
-        if( k <= i )
-            quickSelect( a, left, i - 1, k );
-        else if( k > i + 1 )
-            quickSelect( a, i + 1, right, k );
     }
-    else  // Do an insertion sort on the subarray
-        insertionSort( a, left, right );
+    return order;
 }
 
 /**
- * Quick selection algorithm.
- * Places the kth smallest item in a[k-1].
- * a is an array of Comparable items.
- * k is the desired rank (1 is minimum) in the entire array.
+ * Internal trait for dispatchSort and dispatchStableSort: whether
+ * radixSort sorts Comparable items with Comparator.
  */
-template <typename Comparable>
-void quickSelect( vector<Comparable> & a, int k )
+template <typename Comparable, typename Comparator>
+struct RadixSortable
 {
-    quickSelect( a, 0, a.size( ) - 1, k );
-}
+    static const bool value = is_integral<Comparable>::value && !is_same<Comparable, bool>::value
+                              && sizeof( Comparable ) <= 8 && StandardOrder<Comparator>::isStandard;
+};
 
+/**
+ * Internal trait for dispatchSort and dispatchStableSort: whether
+ * stringSort and stableStringSort sort Comparable items with Comparator.
+ */
+template <typename Comparable, typename Comparator>
+struct StringSortable
+{
+    static const bool value = is_same<Comparable, string>::value && StandardOrder<Comparator>::isStandard;
+};
 
-template <typename Comparable>
-void SORT( vector<Comparable> & items )
+/**
+ * #(This function is added)
+ * Sorts with the engine that suits the items and the input (not stable):
+ *  1. tiny arrays: the introsort leaf (SIMD network for items with 32-bit
+ *     keys ordered by less or greater, insertion sort otherwise);
+ *  2. one pass that stops early unless the input is presorted: sorted
+ *     input is left alone, reversed input is reversed, and a few runs
+ *     are merged by timSort;
+ *  3. integers ordered by less or greater: radixSort; strings ordered
+ *     by less or greater: stringSort;
+ *  4. a type, order and size in the tuning profile: its algorithm;
+ *  5. small trivially copyable items: introsort with the branchless
+ *     block partition;
+ *  6. anything else: quicksort (which sorts large items indirectly).
+ * Returns the engine that ran.
+ * # @compare: less_than or greater_than, able to sort smallest to largest
+ *				or largest to smallest (the version without it uses less)
+ */
+template <typename RandomIt, typename Comparator>
+SortEngine dispatchSort( RandomIt first, RandomIt last, Comparator compare )
 {
-    if( items.size( ) > 1 )
+    typedef typename iterator_traits<RandomIt>::value_type Comparable;
+    auto a = arrayBegin( first );
+    typedef SortLeaf<decltype( a ), Comparator> Leaf;
+
+    int n = checkedSize( first, last );
+    if( n < 2 )
+        return SORT_ENGINE_SORTED;
+    if( n <= Leaf::cutoff( n ) )
     {
-        vector<Comparable> smaller;
-        vector<Comparable> same;
-        vector<Comparable> larger;
-        
-        auto chosenItem = items[ items.size( ) / 2 ];
-        
-        for( auto & i : items )
+        Leaf::sort( a, 0, n - 1, compare );
+        return Leaf::network( ) ? SORT_ENGINE_NETWORK : SORT_ENGINE_INSERTION_SORT;
+    }
+
+    Presortedness order = measurePresortedness( a, n, compare, n / FEW_RUNS_RATIO );
+    if( order.complete )
+    {
+        if( order.descents == 0 )
+            return SORT_ENGINE_SORTED;
+        if( order.ascents == 0 )
         {
-            if( i < chosenItem )
-                smaller.push_back( std::move( i ) );
-            else if( chosenItem < i )
-                larger.push_back( std::move( i ) );
-            else
-                same.push_back( std::move( i ) );
+            std::reverse( first, last );
+            return SORT_ENGINE_REVERSED;
         }
-        
-        SORT( smaller );     // Recursive call!
-        SORT( larger );      // Recursive call!
-        
-        std::move( begin( smaller ), end( smaller ), begin( items ) );
-        std::move( begin( same ), end( same ), begin( items ) + smaller.size( ) );
-        std::move( begin( larger ), end( larger ), end( items ) - larger.size( ) );
+        timSort( first, last, compare );
+        return SORT_ENGINE_TIMSORT;
+    }
 
-/*
-        items.clear( );
-        items.insert( end( items ), begin( smaller ), end( smaller ) );
-        items.insert( end( items ), begin( same ), end( same ) );
-        items.insert( end( items ), begin( larger ), end( larger ) );
-*/
+    if constexpr( RadixSortable<Comparable, Comparator>::value )
+        if( n >= RADIX_SORT_MIN_SIZE )
+        {
+            radixSort( first, last, compare );
+            return SORT_ENGINE_RADIX_SORT;
+        }
+    if constexpr( StringSortable<Comparable, Comparator>::value )
+        if( n >= RADIX_SORT_MIN_SIZE )
+        {
+            stringSort( first, last, compare );
+            return SORT_ENGINE_STRING_SORT;
+        }
+
+    if( const TuningEntry *entry = findTuning<Comparable, Comparator>( n ) )
+    {
+        static const SortEngine engines[ TUNED_ALGORITHM_COUNT ] =
+            { SORT_ENGINE_QUICKSORT, SORT_ENGINE_MERGE_SORT, SORT_ENGINE_HEAPSORT,
+              SORT_ENGINE_THREE_WAY_QUICKSORT, SORT_ENGINE_TIMSORT };
+        tunedSort( first, last, compare );
+        return engines[ entry->algorithm ];
+    }
+
+    if constexpr( is_trivially_copyable<Comparable>::value && sizeof( Comparable ) <= 16 )
+    {
+        introsort<NintherPivot, BlockPartition>( first, last, compare );
+        return SORT_ENGINE_BLOCK_QUICKSORT;
+    }
+    else
+    {
+        quicksort( first, last, compare );
+        return SORT_ENGINE_QUICKSORT;
     }
 }
 
-/*
- * This is the more public version of insertion sort.
- * It requires a pair of iterators and a comparison
- * function object.
- * #(compare is added)
+template <typename Comparable, typename Comparator>
+SortEngine dispatchSort( vector<Comparable> & a, Comparator compare )
+{
+    return dispatchSort( a.begin( ), a.end( ), compare );
+}
+
+template <typename Comparable, typename Comparator>
+SortEngine dispatchSort( span<Comparable> a, Comparator compare )
+{
+    return dispatchSort( a.begin( ), a.end( ), compare );
+}
+
+template <typename Comparable>
+SortEngine dispatchSort( vector<Comparable> & a )
+{
+    return dispatchSort( a.begin( ), a.end( ), less<Comparable>{ } );
+}
+
+/**
+ * #(This function is added)
+ * Stable sort with the engine that suits the items and the input:
+ *  1. tiny arrays: insertion sort;
+ *  2. the same pass as dispatchSort: sorted input is left alone, strictly
+ *     decreasing input is reversed, and a few runs go to timSort;
+ *  3. integers ordered by less or greater: radixSort (equal integers
+ *     cannot be told apart); strings ordered by less or greater:
+ *     stableStringSort;
+ *  4. a tuning profile that chose timSort: timSort;
+ *  5. anything else: mergeSort (which sorts large items indirectly).
+ * Returns the engine that ran.
  * # @compare: less_than or greater_than, able to sort smallest to largest
- *				or largest to smallest
+ *				or largest to smallest (the version without it uses less)
  */
-template <typename RandomIterator, typename Comparator>
-void insertionSort( const RandomIterator & begin,
-                    const RandomIterator & end,
-                    Comparator compare )
+template <typename RandomIt, typename Comparator>
+SortEngine dispatchStableSort( RandomIt first, RandomIt last, Comparator compare )
 {
-    if( begin == end )
-        return;
-        
-    RandomIterator j;
+    typedef typename iterator_traits<RandomIt>::value_type Comparable;
+    auto a = arrayBegin( first );
 
-    for( RandomIterator p = begin+1; p != end; ++p )
+    int n = checkedSize( first, last );
+    if( n < 2 )
+        return SORT_ENGINE_SORTED;
+    if( n <= SMALL_SORT_MAX )
     {
-        auto tmp = std::move( *p );
-        for( j = p; j != begin && compare( tmp, *( j-1 ) ); --j )
-            *j = std::move( *(j-1) );
-        *j = std::move( tmp );
+        insertionSort( a, 0, n - 1, compare );
+        return SORT_ENGINE_INSERTION_SORT;
+    }
+
+    Presortedness order = measurePresortedness( a, n, compare, n / FEW_RUNS_RATIO );
+    if( order.complete )
+    {
+        if( order.descents == 0 )
+            return SORT_ENGINE_SORTED;
+        if( order.ascents == 0 && order.equal == 0 )
+        {
+            std::reverse( first, last );
+            return SORT_ENGINE_REVERSED;
+        }
+        timSort( first, last, compare );
+        return SORT_ENGINE_TIMSORT;
+    }
+
+    if constexpr( RadixSortable<Comparable, Comparator>::value )
+        if( n >= RADIX_SORT_MIN_SIZE )
+        {
+            radixSort( first, last, compare );
+            return SORT_ENGINE_RADIX_SORT;
+        }
+    if constexpr( StringSortable<Comparable, Comparator>::value )
+        if( n >= RADIX_SORT_MIN_SIZE )
+        {
+            stableStringSort( first, last, compare );
+            return SORT_ENGINE_STABLE_STRING_SORT;
+        }
+
+    const TuningEntry *entry = findTuning<Comparable, Comparator>( n );
+    if( entry != nullptr && entry->algorithm == TUNED_TIMSORT )
+    {
+        timSort( first, last, compare );
+        return SORT_ENGINE_TIMSORT;
     }
+    mergeSort( first, last, compare );
+    return SORT_ENGINE_MERGE_SORT;
 }
 
-/*
- * The two-parameter version calls the three parameter version, using C++11 decltype
- */
-template <typename RandomIterator>
-void insertionSort( const RandomIterator & begin,
-                    const RandomIterator & end )
+template <typename Comparable, typename Comparator>
+SortEngine dispatchStableSort( vector<Comparable> & a, Comparator compare )
 {
-    insertionSort( begin, end, less<decltype(*begin )>{ } );
+    return dispatchStableSort( a.begin( ), a.end( ), compare );
+}
+
+template <typename Comparable, typename Comparator>
+SortEngine dispatchStableSort( span<Comparable> a, Comparator compare )
+{
+    return dispatchStableSort( a.begin( ), a.end( ), compare );
 }
 
+template <typename Comparable>
+SortEngine dispatchStableSort( vector<Comparable> & a )
+{
+    return dispatchStableSort( a.begin( ), a.end( ), less<Comparable>{ } );
+}
 
 
 #endif
@@ -0,0 +1,253 @@
+// Tuning profile of the routines in Sort.h
+
+
+#ifndef SORT_TUNING_H
+#define SORT_TUNING_H
+
+/**
+ * Host tuning profile of the sorting routines.
+ * tune_sorting measures on the host, for each element type, order (less
+ * or greater) and size bucket, the fastest insertion sort cutoff of the
+ * quicksorts and the fastest of quicksort, mergeSort, heapsort, SORT and
+ * timSort, and saves them in a small text file. The first sort that
+ * looks at the profile loads the file named by the environment variable
+ * SORT_TUNING_PROFILE, or sort_tuning.profile in the working directory;
+ * without a file every routine keeps its built-in defaults.
+ * A line of the file is
+ *     <type> <less|greater> <log2 of the size> <algorithm> <cutoff>
+ * and lines starting with "#" are comments.
+ */
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+using namespace std;
+
+/**
+ * The algorithms a profile chooses from.
+ */
+enum TunedAlgorithm
+{
+    TUNED_QUICKSORT,
+    TUNED_MERGE_SORT,
+    TUNED_HEAPSORT,
+    TUNED_THREE_WAY_QUICKSORT,
+    TUNED_TIMSORT,
+    TUNED_ALGORITHM_COUNT
+};
+
+inline const char *tunedAlgorithmName( int algorithm )
+{
+    static const char *names[ TUNED_ALGORITHM_COUNT ] =
+        { "quicksort", "mergeSort", "heapsort", "SORT", "timSort" };
+    return names[ algorithm ];
+}
+
+/**
+ * The element types a profile has entries for.
+ */
+enum TunedType
+{
+    TUNED_INT32,
+    TUNED_INT64,
+    TUNED_DOUBLE,
+    TUNED_STRING,
+    TUNED_TYPE_COUNT
+};
+
+inline const char *tunedTypeName( int type )
+{
+    static const char *names[ TUNED_TYPE_COUNT ] = { "int32", "int64", "double", "string" };
+    return names[ type ];
+}
+
+/**
+ * The TunedType of Comparable, -1 if it is not profiled.
+ */
+template <typename Comparable>
+struct TuningType
+{
+    static const int index = -1;
+};
+
+template <>
+struct TuningType<int32_t>
+{
+    static const int index = TUNED_INT32;
+};
+
+template <>
+struct TuningType<int64_t>
+{
+    static const int index = TUNED_INT64;
+};
+
+template <>
+struct TuningType<double>
+{
+    static const int index = TUNED_DOUBLE;
+};
+
+template <>
+struct TuningType<string>
+{
+    static const int index = TUNED_STRING;
+};
+
+/**
+ * Size buckets: n items fall in bucket floor( log2( n ) ).
+ */
+const int TUNING_SIZE_BUCKETS = 32;
+
+inline int tuningBucket( long long n )
+{
+    if( n < 2 )
+        return 0;
+    return min<int>( bit_width( (unsigned long long) n ) - 1, TUNING_SIZE_BUCKETS - 1 );
+}
+
+/**
+ * Largest leaf cutoff a profile may set: a larger cutoff would turn the
+ * quicksorts into insertion sorts, so load rejects it and the sorts
+ * clamp to it.
+ */
+const int TUNING_MAX_CUTOFF = 64;
+
+/**
+ * What the profile chose for one type, order and size bucket.
+ * algorithm is -1 when nothing was measured.
+ */
+struct TuningEntry
+{
+    int algorithm = -1;
+    int cutoff = 0;
+
+    bool tuned( ) const
+      { return algorithm >= 0; }
+};
+
+/**
+ * The profile: the measured entries, and for every bucket the entry of
+ * the nearest measured bucket of the same type and order.
+ * load, set and clear are not synchronized with the sorts that read the
+ * profile; tune before sorting on other threads.
+ */
+class SortTuningProfile
+{
+  public:
+    const TuningEntry & find( int type, bool descending, long long n ) const
+      { return resolved[ type ][ descending ][ tuningBucket( n ) ]; }
+
+    void set( int type, bool descending, int bucket, const TuningEntry & entry )
+    {
+        measured[ type ][ descending ][ bucket ] = entry;
+        resolve( );
+    }
+
+    void clear( )
+    {
+        *this = SortTuningProfile( );
+    }
+
+    /**
+     * Adds the entries of the profile file at path; lines that do not
+     * parse, or whose cutoff is not in 1 .. TUNING_MAX_CUTOFF, are skipped.
+     * Returns false if the file cannot be read.
+     */
+    bool load( const string & path )
+    {
+        ifstream in( path );
+        if( !in )
+            return false;
+        string line;
+        while( getline( in, line ) )
+        {
+            istringstream fields( line );
+            string typeName, order, algorithmName;
+            int bucket, cutoff;
+            if( line.empty( ) || line[ 0 ] == '#'
+                || !( fields >> typeName >> order >> bucket >> algorithmName >> cutoff ) )
+                continue;
+            int type = indexOf( typeName, tunedTypeName, TUNED_TYPE_COUNT );
+            int algorithm = indexOf( algorithmName, tunedAlgorithmName, TUNED_ALGORITHM_COUNT );
+            if( type < 0 || algorithm < 0 || ( order != "less" && order != "greater" )
+                || bucket < 0 || bucket >= TUNING_SIZE_BUCKETS
+                || cutoff < 1 || cutoff > TUNING_MAX_CUTOFF )
+                continue;
+            measured[ type ][ order == "greater" ][ bucket ] = TuningEntry{ algorithm, cutoff };
+        }
+        resolve( );
+        return true;
+    }
+
+    /**
+     * Writes the measured entries to path. Returns false on an error.
+     */
+    bool save( const string & path ) const
+    {
+        ofstream out( path );
+        out << "# <type> <less|greater> <log2 of the size> <algorithm> <cutoff>\n";
+        for( int type = 0; type < TUNED_TYPE_COUNT; ++type )
+            for( int descending = 0; descending < 2; ++descending )
+                for( int bucket = 0; bucket < TUNING_SIZE_BUCKETS; ++bucket )
+                {
+                    const TuningEntry & entry = measured[ type ][ descending ][ bucket ];
+                    if( entry.tuned( ) )
+                        out << tunedTypeName( type ) << ( descending ? " greater " : " less " ) << bucket
+                            << " " << tunedAlgorithmName( entry.algorithm ) << " " << entry.cutoff << "\n";
+                }
+        out.close( );
+        return bool( out );
+    }
+
+  private:
+    TuningEntry measured[ TUNED_TYPE_COUNT ][ 2 ][ TUNING_SIZE_BUCKETS ];
+    TuningEntry resolved[ TUNED_TYPE_COUNT ][ 2 ][ TUNING_SIZE_BUCKETS ];
+
+    void resolve( )
+    {
+        for( int type = 0; type < TUNED_TYPE_COUNT; ++type )
+            for( int descending = 0; descending < 2; ++descending )
+                for( int bucket = 0; bucket < TUNING_SIZE_BUCKETS; ++bucket )
+                {
+                    TuningEntry & entry = resolved[ type ][ descending ][ bucket ];
+                    entry = TuningEntry( );
+                    for( int distance = 0; distance < TUNING_SIZE_BUCKETS && !entry.tuned( ); ++distance )
+                    {
+                        if( bucket - distance >= 0 )
+                            entry = measured[ type ][ descending ][ bucket - distance ];
+                        if( !entry.tuned( ) && bucket + distance < TUNING_SIZE_BUCKETS )
+                            entry = measured[ type ][ descending ][ bucket + distance ];
+                    }
+                }
+    }
+
+    static int indexOf( const string & name, const char *( *nameOf )( int ), int count )
+    {
+        for( int i = 0; i < count; ++i )
+            if( name == nameOf( i ) )
+                return i;
+        return -1;
+    }
+};
+
+/**
+ * The profile of this process, loaded on first use.
+ */
+inline SortTuningProfile & sortTuningProfile( )
+{
+    static SortTuningProfile profile = [ ]
+    {
+        SortTuningProfile loaded;
+        const char *path = getenv( "SORT_TUNING_PROFILE" );
+        loaded.load( path != nullptr ? path : "sort_tuning.profile" );
+        return loaded;
+    }( );
+    return profile;
+}
+
+#endif
@@ -0,0 +1,643 @@
+// Sorting networks for the leaves of the routines in Sort.h
+// The comments begin with "#" follow the same convention as Sort.h
+
+
+#ifndef SORTING_NETWORKS_H
+#define SORTING_NETWORKS_H
+
+/**
+ * Sorting networks for small arrays of arithmetic items.
+ * A network does the same compare-exchanges whatever the data is, so the
+ * exchanges compile to min/max (or conditional moves) instead of branches.
+ * Integers of at most 32 bits and floats use SSE4.1 or AVX2 bitonic
+ * networks on 32-bit integer keys when the CPU has them (checked once at
+ * run time); other types use a scalar Batcher odd-even merge network.
+ * Arrays whose size is known at compile time (std::array<T, N>, T[ N ])
+ * use staticNetworkSort, a network generated and unrolled at compile time.
+ */
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <utility>
+using namespace std;
+
+#if ( defined( __x86_64__ ) || defined( __i386__ ) ) && defined( __GNUC__ )
+#include <immintrin.h>
+#define SORTING_NETWORKS_X86 1
+#else
+#define SORTING_NETWORKS_X86 0
+#endif
+
+/**
+ * Largest array networkSort accepts.
+ */
+const int NETWORK_SORT_MAX = 32;
+
+/**
+ * Instruction sets networkSort can use for items with 32-bit keys.
+ */
+enum NetworkIsa { NETWORK_SCALAR, NETWORK_SSE41, NETWORK_AVX2 };
+
+/**
+ * The best instruction set of this CPU, detected on the first call.
+ */
+inline NetworkIsa networkIsa( )
+{
+#if SORTING_NETWORKS_X86
+    static const NetworkIsa isa =
+        __builtin_cpu_supports( "avx2" ) ? NETWORK_AVX2 :
+        __builtin_cpu_supports( "sse4.1" ) ? NETWORK_SSE41 : NETWORK_SCALAR;
+    return isa;
+#else
+    return NETWORK_SCALAR;
+#endif
+}
+
+/**
+ * Internal method for the scalar networks.
+ * Orders x and y (ascending, or descending if Descending) without a branch.
+ * Both selects use the same condition, so no item is lost even when the
+ * items are unordered (NaN).
+ */
+template <bool Descending, typename T>
+inline void networkCompareExchange( T & x, T & y )
+{
+    bool out = Descending ? x < y : y < x;
+    T lo = out ? y : x;
+    T hi = out ? x : y;
+    x = lo;
+    y = hi;
+}
+
+/**
+ * Batcher's odd-even merge sort network for exactly N items
+ * (N a power of two). The loop bounds are compile-time constants.
+ */
+template <int N, bool Descending, typename T>
+void batcherNetworkSort( T *v )
+{
+    for( int p = 1; p < N; p <<= 1 )
+        for( int k = p; k >= 1; k >>= 1 )
+            for( int j = k % p; j + k < N; j += 2 * k )
+                for( int i = 0; i < k && i + j + k < N; ++i )
+                    if( ( i + j ) / ( 2 * p ) == ( i + j + k ) / ( 2 * p ) )
+                        networkCompareExchange<Descending>( v[ i + j ], v[ i + j + k ] );
+}
+
+/**
+ * Internal method for networkSort.
+ * The item that goes after every other item, used to pad a short array.
+ */
+template <typename T>
+T networkPadding( bool descending )
+{
+    typedef numeric_limits<T> Limits;
+    if( descending )
+        return Limits::has_infinity ? -Limits::infinity( ) : Limits::lowest( );
+    return Limits::has_infinity ? Limits::infinity( ) : Limits::max( );
+}
+
+/**
+ * Internal method for networkSort.
+ * Sorts v[ 0 .. n - 1 ] (n <= N) with a padded N-item Batcher network.
+ */
+template <int N, bool Descending, typename T>
+void paddedNetworkSort( T *v, int n )
+{
+    T buf[ N ];
+    for( int i = 0; i < N; ++i )
+        buf[ i ] = i < n ? v[ i ] : networkPadding<T>( Descending );
+    batcherNetworkSort<N, Descending>( buf );
+    for( int i = 0; i < n; ++i )
+        v[ i ] = buf[ i ];
+}
+
+/**
+ * Scalar network sort of v[ 0 .. n - 1 ], n <= NETWORK_SORT_MAX.
+ */
+template <typename T>
+void scalarNetworkSort( T *v, int n, bool descending )
+{
+    if( n <= 1 )
+        return;
+    if( descending )
+    {
+        if( n <= 8 )
+            paddedNetworkSort<8, true>( v, n );
+        else if( n <= 16 )
+            paddedNetworkSort<16, true>( v, n );
+        else
+            paddedNetworkSort<32, true>( v, n );
+    }
+    else
+    {
+        if( n <= 8 )
+            paddedNetworkSort<8, false>( v, n );
+        else if( n <= 16 )
+            paddedNetworkSort<16, false>( v, n );
+        else
+            paddedNetworkSort<32, false>( v, n );
+    }
+}
+
+#if SORTING_NETWORKS_X86
+
+/**
+ * Internal methods for the SSE4.1 bitonic network: 4 items per register.
+ * exchange pairs lane i with lane perm( i ) and keeps the larger item in
+ * the lanes set in takeMax.
+ */
+template <int Perm>
+__attribute__(( target( "sse4.1" ) ))
+inline __m128i sseExchange( __m128i v, __m128i takeMax )
+{
+    __m128i w = _mm_shuffle_epi32( v, Perm );
+    return _mm_blendv_epi8( _mm_min_epi32( v, w ), _mm_max_epi32( v, w ), takeMax );
+}
+
+__attribute__(( target( "sse4.1" ) ))
+inline __m128i sseReverse( __m128i v )
+{
+    return _mm_shuffle_epi32( v, _MM_SHUFFLE( 0, 1, 2, 3 ) );
+}
+
+    // Sorts a bitonic register
+__attribute__(( target( "sse4.1" ) ))
+inline __m128i sseClean4( __m128i v )
+{
+    v = sseExchange<_MM_SHUFFLE( 1, 0, 3, 2 )>( v, _mm_setr_epi32( 0, 0, -1, -1 ) );
+    v = sseExchange<_MM_SHUFFLE( 2, 3, 0, 1 )>( v, _mm_setr_epi32( 0, -1, 0, -1 ) );
+    return v;
+}
+
+__attribute__(( target( "sse4.1" ) ))
+inline __m128i sseSort4( __m128i v )
+{
+    v = sseExchange<_MM_SHUFFLE( 2, 3, 0, 1 )>( v, _mm_setr_epi32( 0, -1, -1, 0 ) );
+    return sseClean4( v );
+}
+
+    // Sorts the bitonic sequence a ++ b
+__attribute__(( target( "sse4.1" ) ))
+inline void sseClean8( __m128i & a, __m128i & b )
+{
+    __m128i lo = _mm_min_epi32( a, b );
+    __m128i hi = _mm_max_epi32( a, b );
+    a = sseClean4( lo );
+    b = sseClean4( hi );
+}
+
+__attribute__(( target( "sse4.1" ) ))
+inline void sseSort8( __m128i & a, __m128i & b )
+{
+    a = sseSort4( a );
+    b = sseReverse( sseSort4( b ) );
+    sseClean8( a, b );
+}
+
+/**
+ * Internal method for networkSort.
+ * Sorts buf[ 0 .. 4 * regs - 1 ] ascending; regs is 2 or 4.
+ */
+__attribute__(( target( "sse4.1" ) ))
+inline void sseNetworkSort( int32_t *buf, int regs )
+{
+    __m128i a = _mm_loadu_si128( (const __m128i *) buf );
+    __m128i b = _mm_loadu_si128( (const __m128i *) ( buf + 4 ) );
+    sseSort8( a, b );
+    if( regs == 4 )
+    {
+        __m128i c = _mm_loadu_si128( (const __m128i *) ( buf + 8 ) );
+        __m128i d = _mm_loadu_si128( (const __m128i *) ( buf + 12 ) );
+        sseSort8( c, d );
+        __m128i rc = sseReverse( d );   // c ++ d reversed is descending
+        __m128i rd = sseReverse( c );
+        __m128i lo0 = _mm_min_epi32( a, rc ), hi0 = _mm_max_epi32( a, rc );
+        __m128i lo1 = _mm_min_epi32( b, rd ), hi1 = _mm_max_epi32( b, rd );
+        sseClean8( lo0, lo1 );
+        sseClean8( hi0, hi1 );
+        a = lo0; b = lo1; c = hi0; d = hi1;
+        _mm_storeu_si128( (__m128i *) ( buf + 8 ), c );
+        _mm_storeu_si128( (__m128i *) ( buf + 12 ), d );
+    }
+    _mm_storeu_si128( (__m128i *) buf, a );
+    _mm_storeu_si128( (__m128i *) ( buf + 4 ), b );
+}
+
+/**
+ * Internal methods for the AVX2 bitonic network: 8 items per register.
+ * exchange pairs lane i with lane perm[ i ] and keeps the larger item in
+ * the lanes set in takeMax.
+ */
+__attribute__(( target( "avx2" ) ))
+inline __m256i avx2Exchange( __m256i v, __m256i perm, __m256i takeMax )
+{
+    __m256i w = _mm256_permutevar8x32_epi32( v, perm );
+    return _mm256_blendv_epi8( _mm256_min_epi32( v, w ), _mm256_max_epi32( v, w ), takeMax );
+}
+
+__attribute__(( target( "avx2" ) ))
+inline __m256i avx2Reverse( __m256i v )
+{
+    return _mm256_permutevar8x32_epi32( v, _mm256_setr_epi32( 7, 6, 5, 4, 3, 2, 1, 0 ) );
+}
+
+    // Sorts a bitonic register
+__attribute__(( target( "avx2" ) ))
+inline __m256i avx2Clean8( __m256i v )
+{
+    v = avx2Exchange( v, _mm256_setr_epi32( 4, 5, 6, 7, 0, 1, 2, 3 ),
+                      _mm256_setr_epi32( 0, 0, 0, 0, -1, -1, -1, -1 ) );
+    v = avx2Exchange( v, _mm256_setr_epi32( 2, 3, 0, 1, 6, 7, 4, 5 ),
+                      _mm256_setr_epi32( 0, 0, -1, -1, 0, 0, -1, -1 ) );
+    v = avx2Exchange( v, _mm256_setr_epi32( 1, 0, 3, 2, 5, 4, 7, 6 ),
+                      _mm256_setr_epi32( 0, -1, 0, -1, 0, -1, 0, -1 ) );
+    return v;
+}
+
+__attribute__(( target( "avx2" ) ))
+inline __m256i avx2Sort8( __m256i v )
+{
+    v = avx2Exchange( v, _mm256_setr_epi32( 1, 0, 3, 2, 5, 4, 7, 6 ),
+                      _mm256_setr_epi32( 0, -1, -1, 0, 0, -1, -1, 0 ) );
+    v = avx2Exchange( v, _mm256_setr_epi32( 2, 3, 0, 1, 6, 7, 4, 5 ),
+                      _mm256_setr_epi32( 0, 0, -1, -1, -1, -1, 0, 0 ) );
+    v = avx2Exchange( v, _mm256_setr_epi32( 1, 0, 3, 2, 5, 4, 7, 6 ),
+                      _mm256_setr_epi32( 0, -1, 0, -1, -1, 0, -1, 0 ) );
+    return avx2Clean8( v );
+}
+
+    // Sorts the bitonic sequence a ++ b
+__attribute__(( target( "avx2" ) ))
+inline void avx2Clean16( __m256i & a, __m256i & b )
+{
+    __m256i lo = _mm256_min_epi32( a, b );
+    __m256i hi = _mm256_max_epi32( a, b );
+    a = avx2Clean8( lo );
+    b = avx2Clean8( hi );
+}
+
+__attribute__(( target( "avx2" ) ))
+inline void avx2Sort16( __m256i & a, __m256i & b )
+{
+    a = avx2Sort8( a );
+    b = avx2Reverse( avx2Sort8( b ) );
+    avx2Clean16( a, b );
+}
+
+/**
+ * Internal method for networkSort.
+ * Sorts buf[ 0 .. 8 * regs - 1 ] ascending; regs is 1, 2 or 4.
+ */
+__attribute__(( target( "avx2" ) ))
+inline void avx2NetworkSort( int32_t *buf, int regs )
+{
+    __m256i a = _mm256_loadu_si256( (const __m256i *) buf );
+    if( regs == 1 )
+    {
+        _mm256_storeu_si256( (__m256i *) buf, avx2Sort8( a ) );
+        return;
+    }
+
+    __m256i b = _mm256_loadu_si256( (const __m256i *) ( buf + 8 ) );
+    avx2Sort16( a, b );
+    if( regs == 4 )
+    {
+        __m256i c = _mm256_loadu_si256( (const __m256i *) ( buf + 16 ) );
+        __m256i d = _mm256_loadu_si256( (const __m256i *) ( buf + 24 ) );
+        avx2Sort16( c, d );
+        __m256i rc = avx2Reverse( d );   // c ++ d reversed is descending
+        __m256i rd = avx2Reverse( c );
+        __m256i lo0 = _mm256_min_epi32( a, rc ), hi0 = _mm256_max_epi32( a, rc );
+        __m256i lo1 = _mm256_min_epi32( b, rd ), hi1 = _mm256_max_epi32( b, rd );
+        avx2Clean16( lo0, lo1 );
+        avx2Clean16( hi0, hi1 );
+        a = lo0; b = lo1;
+        _mm256_storeu_si256( (__m256i *) ( buf + 16 ), hi0 );
+        _mm256_storeu_si256( (__m256i *) ( buf + 24 ), hi1 );
+    }
+    _mm256_storeu_si256( (__m256i *) buf, a );
+    _mm256_storeu_si256( (__m256i *) ( buf + 8 ), b );
+}
+
+#endif  // SORTING_NETWORKS_X86
+
+/**
+ * Internal key mapping for the SIMD networks, which sort int32_t.
+ * value tells whether T has a key; encode maps an item to an int32_t key
+ * in the same order and decode maps the key back to the same item.
+ * Integers of at most 32 bits (bool excepted) are widened, with the sign bit
+ * of 32-bit unsigned integers flipped; a float keeps its bits, with the other
+ * bits flipped when it is negative, so -0 comes before +0 and NaNs go to the
+ * ends (no order is valid for them with less or greater anyway).
+ * 64-bit items keep the scalar path: SSE4.1 and AVX2 have no 64-bit min/max
+ * (it takes AVX-512), and half as many of them fit in a register.
+ */
+template <typename T, typename = void>
+struct NetworkKey
+{
+    static const bool value = false;
+};
+
+template <typename T>
+struct NetworkKey<T, typename enable_if<is_integral<T>::value && !is_same<T, bool>::value
+                                        && sizeof( T ) <= 4>::type>
+{
+    static const bool value = true;
+    static const bool flip = is_unsigned<T>::value && sizeof( T ) == 4;
+
+    static int32_t encode( T x )
+    {
+        return flip ? int32_t( uint32_t( x ) ^ 0x80000000u ) : int32_t( x );
+    }
+
+    static T decode( int32_t key )
+    {
+        return flip ? T( uint32_t( key ) ^ 0x80000000u ) : T( key );
+    }
+};
+
+template <>
+struct NetworkKey<float>
+{
+    static const bool value = true;
+
+    static int32_t encode( float x )
+    {
+        int32_t bits = bit_cast<int32_t>( x );
+        return bits ^ ( ( bits >> 31 ) & 0x7fffffff );
+    }
+
+    static float decode( int32_t key )
+    {
+        return bit_cast<float>( key ^ ( ( key >> 31 ) & 0x7fffffff ) );
+    }
+};
+
+/**
+ * #(This function is added)
+ * Sorts v[ 0 .. n - 1 ] with a sorting network, n <= NETWORK_SORT_MAX.
+ * Items whose type has a NetworkKey go through the SIMD networks; descending
+ * order sorts the bitwise complements of the keys, which reverses their order.
+ * # @descending: false for less (smallest to largest),
+ *				true for greater (largest to smallest)
+ */
+template <typename T>
+void networkSort( T *v, int n, bool descending )
+{
+    static_assert( is_arithmetic<T>::value, "networkSort needs arithmetic items" );
+    if( n <= 1 )
+        return;
+
+#if SORTING_NETWORKS_X86
+    if constexpr( NetworkKey<T>::value )
+    {
+        NetworkIsa isa = networkIsa( );
+        if( isa == NETWORK_AVX2 || ( isa == NETWORK_SSE41 && n <= 16 ) )
+        {
+            int32_t buf[ NETWORK_SORT_MAX ];
+            int size = n <= 8 ? 8 : n <= 16 ? 16 : 32;
+            int32_t mask = descending ? -1 : 0;
+            for( int i = 0; i < size; ++i )
+                buf[ i ] = i < n ? NetworkKey<T>::encode( v[ i ] ) ^ mask : numeric_limits<int32_t>::max( );
+
+            if( isa == NETWORK_AVX2 )
+                avx2NetworkSort( buf, size / 8 );
+            else
+                sseNetworkSort( buf, size <= 8 ? 2 : 4 );
+
+            for( int i = 0; i < n; ++i )
+                v[ i ] = NetworkKey<T>::decode( buf[ i ] ^ mask );
+            return;
+        }
+    }
+#endif
+    scalarNetworkSort( v, n, descending );
+}
+
+/**
+ * Largest subarray worth handing to networkSort for items of type T:
+ * 32 when AVX2 sorts their keys, 16 otherwise.
+ */
+template <typename T>
+int networkLeafSize( )
+{
+    return NetworkKey<T>::value && networkIsa( ) == NETWORK_AVX2 ? 32 : 16;
+}
+
+/**
+ * #(This section is added)
+ * Compile-time sorting networks for N <= NETWORK_SORT_MAX items.
+ * The list of compare-exchanges of a network is built by a constexpr
+ * function, and staticNetworkSort expands it into straight-line code, so
+ * there is no loop, no index arithmetic and, for arithmetic items, no
+ * branch left; everything works in constant expressions.
+ * Only N <= 8 use networks proven optimal (fewest compare-exchanges).
+ * 9 <= N <= 16 use the best known network of 16 items (60
+ * compare-exchanges) with the compare-exchanges of the wires beyond N
+ * removed, one to three more than the best known network of N items.
+ * 17 <= N <= 32 sort items 0 .. 15 and 16 .. N - 1 that way and merge them
+ * with Batcher's odd-even merge (185 compare-exchanges for N = 32, as
+ * many as the best known network of 32 items).
+ */
+
+/**
+ * One compare-exchange: orders the items at first and second (first < second).
+ */
+struct NetworkComparator
+{
+    unsigned char first;
+    unsigned char second;
+};
+
+/**
+ * The optimal networks of 2 to 8 items, one after the other; the network
+ * of n items is at OPTIMAL_NETWORK_OFFSET[ n ] .. OPTIMAL_NETWORK_OFFSET[ n + 1 ] - 1.
+ */
+const int OPTIMAL_NETWORK_MAX = 8;
+
+inline constexpr NetworkComparator OPTIMAL_NETWORKS[ ] =
+{
+    { 0, 1 },                                                          // 2: 1
+    { 0, 2 }, { 0, 1 }, { 1, 2 },                                      // 3: 3
+    { 0, 1 }, { 2, 3 }, { 0, 2 }, { 1, 3 }, { 1, 2 },                  // 4: 5
+    { 0, 3 }, { 1, 4 }, { 0, 2 }, { 1, 3 }, { 0, 1 }, { 2, 4 },        // 5: 9
+    { 1, 2 }, { 3, 4 }, { 2, 3 },
+    { 0, 5 }, { 1, 3 }, { 2, 4 }, { 1, 2 }, { 3, 4 }, { 0, 3 },        // 6: 12
+    { 2, 5 }, { 0, 1 }, { 2, 3 }, { 4, 5 }, { 1, 2 }, { 3, 4 },
+    { 0, 6 }, { 2, 3 }, { 4, 5 }, { 0, 2 }, { 1, 4 }, { 3, 6 },        // 7: 16
+    { 0, 1 }, { 2, 5 }, { 3, 4 }, { 1, 2 }, { 4, 6 }, { 2, 3 },
+    { 4, 5 }, { 1, 2 }, { 3, 4 }, { 5, 6 },
+    { 0, 2 }, { 1, 3 }, { 4, 6 }, { 5, 7 }, { 0, 4 }, { 1, 5 },        // 8: 19
+    { 2, 6 }, { 3, 7 }, { 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 },
+    { 2, 4 }, { 3, 5 }, { 1, 4 }, { 3, 6 }, { 1, 2 }, { 3, 4 },
+    { 5, 6 }
+};
+
+inline constexpr int OPTIMAL_NETWORK_OFFSET[ OPTIMAL_NETWORK_MAX + 2 ] =
+    { 0, 0, 0, 1, 4, 9, 18, 30, 46, 65 };
+
+/**
+ * The best known network of 16 items: 60 compare-exchanges in 10 layers,
+ * one layer per line.
+ */
+const int BEST_NETWORK_ITEMS = 16;
+
+inline constexpr NetworkComparator BEST_NETWORK[ ] =
+{
+    { 0, 13 }, { 1, 12 }, { 2, 15 }, { 3, 14 }, { 4, 8 }, { 5, 6 }, { 7, 11 }, { 9, 10 },
+    { 0, 5 }, { 1, 7 }, { 2, 9 }, { 3, 4 }, { 6, 13 }, { 8, 14 }, { 10, 15 }, { 11, 12 },
+    { 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 8 }, { 7, 9 }, { 10, 11 }, { 12, 13 }, { 14, 15 },
+    { 0, 2 }, { 1, 3 }, { 4, 10 }, { 5, 11 }, { 6, 7 }, { 8, 9 }, { 12, 14 }, { 13, 15 },
+    { 1, 2 }, { 3, 12 }, { 4, 6 }, { 5, 7 }, { 8, 10 }, { 9, 11 }, { 13, 14 },
+    { 1, 4 }, { 2, 6 }, { 5, 8 }, { 7, 10 }, { 9, 13 }, { 11, 14 },
+    { 2, 4 }, { 3, 6 }, { 9, 12 }, { 11, 13 },
+    { 3, 5 }, { 6, 8 }, { 7, 9 }, { 10, 12 },
+    { 3, 4 }, { 5, 6 }, { 7, 8 }, { 9, 10 }, { 11, 12 },
+    { 6, 7 }, { 8, 9 }
+};
+
+/**
+ * Internal method for staticNetwork.
+ * Visits the compare-exchanges of the network of n items in order, on
+ * the wires offset .. offset + n - 1.
+ */
+template <typename Visitor>
+constexpr void visitNetwork( int n, Visitor visit, int offset = 0 )
+{
+    auto shifted = [ offset ]( NetworkComparator c )
+      { return NetworkComparator{ (unsigned char) ( c.first + offset ), (unsigned char) ( c.second + offset ) }; };
+
+    if( n <= OPTIMAL_NETWORK_MAX )
+    {
+        for( int c = OPTIMAL_NETWORK_OFFSET[ n ]; c < OPTIMAL_NETWORK_OFFSET[ n + 1 ]; ++c )
+            visit( shifted( OPTIMAL_NETWORKS[ c ] ) );
+        return;
+    }
+    if( n <= BEST_NETWORK_ITEMS )
+    {
+        for( NetworkComparator c : BEST_NETWORK )
+            if( c.second < n )      // The wires beyond n would hold items larger than all
+                visit( shifted( c ) );
+        return;
+    }
+
+    visitNetwork( BEST_NETWORK_ITEMS, visit, offset );
+    visitNetwork( n - BEST_NETWORK_ITEMS, visit, offset + BEST_NETWORK_ITEMS );
+    const int p = BEST_NETWORK_ITEMS;      // The last merge of batcherNetworkSort
+    for( int k = p; k >= 1; k >>= 1 )
+        for( int j = k % p; j + k < n; j += 2 * k )
+            for( int i = 0; i < k && i + j + k < n; ++i )
+                if( ( i + j ) / ( 2 * p ) == ( i + j + k ) / ( 2 * p ) )
+                    visit( shifted( NetworkComparator{ (unsigned char) ( i + j ), (unsigned char) ( i + j + k ) } ) );
+}
+
+/**
+ * Number of compare-exchanges of the network of n items.
+ */
+constexpr size_t staticNetworkSize( int n )
+{
+    size_t size = 0;
+    visitNetwork( n, [ & ]( NetworkComparator ) { ++size; } );
+    return size;
+}
+
+/**
+ * The network of N items, built at compile time.
+ */
+template <size_t N>
+constexpr array<NetworkComparator, staticNetworkSize( N )> makeStaticNetwork( )
+{
+    array<NetworkComparator, staticNetworkSize( N )> network{ };
+    size_t size = 0;
+    visitNetwork( N, [ & ]( NetworkComparator c ) { network[ size++ ] = c; } );
+    return network;
+}
+
+template <size_t N>
+inline constexpr auto STATIC_NETWORK = makeStaticNetwork<N>( );
+
+/**
+ * Internal method for staticNetworkSort.
+ * Orders x and y by compare without a branch for arithmetic items: both
+ * are selected by the same condition (no item is lost to a NaN), with
+ * conditional moves for integers and a bit mask for float and double,
+ * which the compiler would otherwise branch on. Other items are swapped
+ * (moved) only when they are out of order.
+ */
+template <typename T, typename Comparator>
+constexpr void staticCompareExchange( T & x, T & y, Comparator & compare )
+{
+    if constexpr( is_floating_point<T>::value && ( sizeof( T ) == 4 || sizeof( T ) == 8 ) )
+    {
+        typedef typename conditional<sizeof( T ) == 4, uint32_t, uint64_t>::type Bits;
+        Bits mask = Bits( 0 ) - Bits( compare( y, x ) );
+        Bits xBits = bit_cast<Bits>( x );
+        Bits yBits = bit_cast<Bits>( y );
+        x = bit_cast<T>( ( yBits & mask ) | ( xBits & ~mask ) );
+        y = bit_cast<T>( ( xBits & mask ) | ( yBits & ~mask ) );
+    }
+    else if constexpr( is_arithmetic<T>::value )
+    {
+        bool out = compare( y, x );
+        T lo = out ? y : x;
+        T hi = out ? x : y;
+        x = lo;
+        y = hi;
+    }
+    else if( compare( y, x ) )
+        std::swap( x, y );
+}
+
+/**
+ * Internal method for staticNetworkSort: sorts v[ 0 .. N - 1 ].
+ */
+template <size_t N, typename T, typename Comparator>
+constexpr void unrolledNetworkSort( T *v, Comparator compare )
+{
+    static_assert( N <= NETWORK_SORT_MAX, "staticNetworkSort sorts at most NETWORK_SORT_MAX items" );
+    constexpr const auto & network = STATIC_NETWORK<N>;
+    [ & ]<size_t... C>( index_sequence<C...> )
+    {
+        ( staticCompareExchange( v[ network[ C ].first ], v[ network[ C ].second ], compare ), ... );
+    }( make_index_sequence<network.size( )>{ } );
+}
+
+/**
+ * #(This function is added)
+ * Sorts an array of N <= NETWORK_SORT_MAX items with a sorting network
+ * unrolled at compile time; can be used in constant expressions.
+ * Not stable.
+ * # @compare: less_than or greater_than, able to sort smallest to largest
+ *				or largest to smallest (the version without it uses less)
+ */
+template <typename T, size_t N, typename Comparator>
+constexpr void staticNetworkSort( array<T, N> & a, Comparator compare )
+{
+    unrolledNetworkSort<N>( a.data( ), compare );
+}
+
+template <typename T, size_t N, typename Comparator>
+constexpr void staticNetworkSort( T ( &a )[ N ], Comparator compare )
+{
+    unrolledNetworkSort<N>( a, compare );
+}
+
+template <typename T, size_t N>
+constexpr void staticNetworkSort( array<T, N> & a )
+{
+    unrolledNetworkSort<N>( a.data( ), less<T>{ } );
+}
+
+template <typename T, size_t N>
+constexpr void staticNetworkSort( T ( &a )[ N ] )
+{
+    unrolledNetworkSort<N>( a, less<T>{ } );
+}
+
+#endif
@@ -0,0 +1,411 @@
+// String sorting engines for the routines in Sort.h
+
+
+#ifndef STRING_SORT_H
+#define STRING_SORT_H
+
+/**
+ * Sorting engines for std::string items.
+ * A comparison sort compares the common prefix of two strings again on
+ * every comparison, and reads each string through its heap pointer.
+ * multikeySort is a multikey (three-way radix) quicksort over an array of
+ * string pointers, each held next to an 8-byte key cached from the
+ * string: 7 bytes starting at the current depth and how many bytes were
+ * left (capped at 8), so one integer comparison orders two strings by 7
+ * more bytes and strings only are read when a bucket goes deeper. Large
+ * buckets are split by an MSD radix step on the next byte first.
+ * lcpMergeSort is a stable merge sort that keeps the longest common prefix
+ * (LCP) of each item with its predecessor, so a merge compares each
+ * character about once.
+ * Both sort by byte value (as std::string does), smallest to largest or,
+ * if descending, largest to smallest.
+ */
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+using namespace std;
+
+/**
+ * Buckets of at most this many strings are finished by insertion sort.
+ */
+const size_t STRING_INSERTION_SORT_CUTOFF = 16;
+
+/**
+ * Buckets of at least this many strings are split by an MSD radix step
+ * on the next byte instead of a three-way partition.
+ */
+const size_t STRING_RADIX_MIN_SIZE = 4096;
+
+/**
+ * Internal class for multikeySort: a string and its key at the current depth.
+ */
+struct StringKey
+{
+    uint64_t prefix;
+    string *text;
+};
+
+/**
+ * Internal method for multikeySort.
+ * The key of s at depth: the (up to) 7 bytes from depth, big-endian and
+ * zero padded, in the high bytes, and the number of bytes left from depth
+ * (8 for 8 or more) in the low byte. Keys order strings as their bytes
+ * from depth do, except that two strings with 8 or more bytes left and
+ * the same key need depth + 7.
+ */
+inline uint64_t stringPrefix( const string & s, size_t depth )
+{
+    size_t left = s.size( ) > depth ? s.size( ) - depth : 0;
+    size_t count = min<size_t>( left, 7 );
+    const unsigned char *bytes = (const unsigned char *) s.data( ) + depth;
+    uint64_t prefix = 0;
+    for( size_t i = 0; i < count; ++i )
+        prefix |= uint64_t( bytes[ i ] ) << ( 56 - 8 * i );
+    return prefix | min<size_t>( left, 8 );
+}
+
+/**
+ * Internal method for multikeySort.
+ * Whether strings with the key prefix have bytes beyond depth + 7.
+ */
+inline bool stringContinues( uint64_t prefix )
+{
+    return ( prefix & 0xFF ) == 8;
+}
+
+/**
+ * Internal method for multikeySort.
+ * Compares the strings of x and y, which are equal before depth:
+ * negative, zero or positive as x is before, equal to or after y.
+ */
+inline int compareStringKeys( const StringKey & x, const StringKey & y, size_t depth )
+{
+    if( x.prefix != y.prefix )
+        return x.prefix < y.prefix ? -1 : 1;
+    if( !stringContinues( x.prefix ) )
+        return 0;
+    return string_view( *x.text ).substr( depth + 7 ).compare( string_view( *y.text ).substr( depth + 7 ) );
+}
+
+/**
+ * Internal method for multikeySort.
+ * Insertion sort of a[ 0 .. n - 1 ], whose strings are equal before depth.
+ */
+inline void insertionSortStrings( StringKey *a, size_t n, size_t depth )
+{
+    for( size_t p = 1; p < n; ++p )
+    {
+        StringKey tmp = a[ p ];
+        size_t j;
+        for( j = p; j > 0 && compareStringKeys( tmp, a[ j - 1 ], depth ) < 0; --j )
+            a[ j ] = a[ j - 1 ];
+        a[ j ] = tmp;
+    }
+}
+
+/**
+ * Internal method for multikeySort.
+ * Heapsort of a[ 0 .. n - 1 ], for buckets that keep partitioning badly.
+ */
+inline void heapsortStrings( StringKey *a, size_t n, size_t depth )
+{
+    auto before = [ depth ]( const StringKey & x, const StringKey & y )
+      { return compareStringKeys( x, y, depth ) < 0; };
+    make_heap( a, a + n, before );
+    sort_heap( a, a + n, before );
+}
+
+/**
+ * Internal method for multikeySort.
+ * Partitions allowed on one bucket before it is heapsorted:
+ * 2 * log2( n ), as in introsort.
+ */
+inline int stringDepthLimit( size_t n )
+{
+    int limit = 0;
+    for( ; n > 1; n >>= 1 )
+        limit += 2;
+    return limit;
+}
+
+inline void multikeyQuicksort( StringKey *a, size_t n, size_t depth, int depthLimit, bool radix,
+                               vector<StringKey> & buffer );
+
+/**
+ * Internal method for multikeySort.
+ * MSD radix step: distributes a[ 0 .. n - 1 ] by the byte at depth (0 past
+ * the end) through buffer, then sorts each bucket by multikeyQuicksort.
+ * The buckets keep their keys and are only partitioned (no radix step)
+ * until they go deeper.
+ */
+inline void msdRadixStep( StringKey *a, size_t n, size_t depth, int depthLimit,
+                          vector<StringKey> & buffer )
+{
+    size_t start[ 257 ] = { };
+    for( size_t i = 0; i < n; ++i )
+        ++start[ ( a[ i ].prefix >> 56 ) + 1 ];
+    for( int b = 0; b < 256; ++b )
+        start[ b + 1 ] += start[ b ];
+
+    size_t next[ 256 ];
+    copy( start, start + 256, next );
+    for( size_t i = 0; i < n; ++i )
+        buffer[ next[ a[ i ].prefix >> 56 ]++ ] = a[ i ];
+    copy( buffer.begin( ), buffer.begin( ) + n, a );
+
+    for( int b = 0; b < 256; ++b )
+        if( start[ b + 1 ] - start[ b ] > 1 )
+            multikeyQuicksort( a + start[ b ], start[ b + 1 ] - start[ b ], depth, depthLimit, false, buffer );
+}
+
+/**
+ * Internal method for multikeySort.
+ * Sorts a[ 0 .. n - 1 ], whose strings are equal before depth and whose
+ * keys are taken at depth. Partitions by the key of the median of three
+ * items into smaller, equal and larger keys; the equal keys go on at
+ * depth + 7 (after reloading them) unless their strings ended.
+ * Large arrays are split by msdRadixStep first if radix, which is false
+ * for the buckets of a radix step at the same depth.
+ * buffer has room for n items when n >= STRING_RADIX_MIN_SIZE.
+ */
+inline void multikeyQuicksort( StringKey *a, size_t n, size_t depth, int depthLimit, bool radix,
+                               vector<StringKey> & buffer )
+{
+    while( n > STRING_INSERTION_SORT_CUTOFF )
+    {
+        if( depthLimit-- == 0 )
+        {
+            heapsortStrings( a, n, depth );
+            return;
+        }
+        if( radix && n >= STRING_RADIX_MIN_SIZE )
+        {
+            msdRadixStep( a, n, depth, depthLimit, buffer );
+            return;
+        }
+
+        uint64_t x = a[ 0 ].prefix, y = a[ n / 2 ].prefix, z = a[ n - 1 ].prefix;
+        uint64_t pivot = max( min( x, y ), min( max( x, y ), z ) );
+
+            // Three-way partition: a[ 0 .. lt - 1 ] < pivot, a[ gt .. n - 1 ] > pivot
+        size_t lt = 0, i = 0, gt = n;
+        while( i < gt )
+        {
+            if( a[ i ].prefix < pivot )
+                std::swap( a[ lt++ ], a[ i++ ] );
+            else if( a[ i ].prefix > pivot )
+                std::swap( a[ i ], a[ --gt ] );
+            else
+                ++i;
+        }
+
+        multikeyQuicksort( a, lt, depth, depthLimit, radix, buffer );
+        multikeyQuicksort( a + gt, n - gt, depth, depthLimit, radix, buffer );
+        if( !stringContinues( pivot ) )
+            return;    // The equal keys are equal strings
+
+        a += lt;
+        n = gt - lt;
+        depth += 7;
+        for( size_t k = 0; k < n; ++k )
+            a[ k ].prefix = stringPrefix( *a[ k ].text, depth );
+        depthLimit = stringDepthLimit( n );
+        radix = true;
+    }
+    insertionSortStrings( a, n, depth );
+}
+
+/**
+ * Internal method for multikeySort and lcpMergeSort.
+ * Moves the strings of texts[ 0 .. n - 1 ] (pointers into the range
+ * first .. last) to the range in that order, or in reverse order.
+ */
+template <typename RandomIt, typename StringPtr>
+void moveStringsInOrder( RandomIt first, const StringPtr *texts, size_t n, bool reverse )
+{
+    vector<string> sorted( n );
+    for( size_t k = 0; k < n; ++k )
+        sorted[ k ] = std::move( *texts[ reverse ? n - 1 - k : k ] );
+    std::move( sorted.begin( ), sorted.end( ), first );
+}
+
+/**
+ * Multikey quicksort of the strings in first .. last (not stable).
+ * Sorts the strings smallest to largest, or largest to smallest if
+ * descending; each string is moved twice.
+ */
+template <typename RandomIt>
+void multikeySort( RandomIt first, RandomIt last, bool descending )
+{
+    size_t n = size_t( last - first );
+    if( n < 2 )
+        return;
+
+    vector<StringKey> keys( n );
+    for( size_t i = 0; i < n; ++i )
+    {
+        string & s = first[ i ];
+        keys[ i ] = StringKey{ stringPrefix( s, 0 ), &s };
+    }
+    vector<StringKey> buffer( n >= STRING_RADIX_MIN_SIZE ? n : 0 );
+    multikeyQuicksort( keys.data( ), n, 0, stringDepthLimit( n ), true, buffer );
+
+    vector<string *> texts( n );
+    for( size_t i = 0; i < n; ++i )
+        texts[ i ] = keys[ i ].text;
+    moveStringsInOrder( first, texts.data( ), n, descending );
+}
+
+/**
+ * Internal method for lcpMergeSort.
+ * Compares x and y, which are equal before lcp, and advances lcp to
+ * their longest common prefix. Returns negative, zero or positive as x is
+ * before, equal to or after y (smallest to largest).
+ */
+inline int compareFromLcp( const string & x, const string & y, size_t & lcp )
+{
+    size_t n = min( x.size( ), y.size( ) );
+    for( ; lcp + 8 <= n; lcp += 8 )    // 8 bytes at a time
+    {
+        uint64_t u, v;
+        memcpy( &u, x.data( ) + lcp, 8 );
+        memcpy( &v, y.data( ) + lcp, 8 );
+        if( u != v )
+        {
+            lcp += ( endian::native == endian::little ? countr_zero( u ^ v ) : countl_zero( u ^ v ) ) / 8;
+            break;
+        }
+    }
+    while( lcp < n && x[ lcp ] == y[ lcp ] )
+        ++lcp;
+    if( lcp < n )
+        return (unsigned char) x[ lcp ] < (unsigned char) y[ lcp ] ? -1 : 1;
+    return x.size( ) < y.size( ) ? -1 : x.size( ) > y.size( ) ? 1 : 0;
+}
+
+/**
+ * Internal method for lcpMergeSort.
+ * Merges the sorted runs a[ 0 .. na - 1 ] and b[ 0 .. nb - 1 ] into out.
+ * lcpA[ i ] is the LCP of a[ i ] with a[ i - 1 ] (any value for i = 0), the
+ * same for lcpB, and lcpOut gets the LCPs of the merged run.
+ * ha and hb are the LCPs of the heads of a and b with the last item
+ * moved to out: the head sharing more with it is the next one, and only
+ * heads sharing as much are compared, from that many characters on.
+ * Equal items keep a's first.
+ */
+inline void lcpMerge( string **a, const size_t *lcpA, size_t na,
+                      string **b, const size_t *lcpB, size_t nb,
+                      string **out, size_t *lcpOut, bool descending )
+{
+    size_t i = 0, j = 0, k = 0;
+    size_t ha = 0, hb = 0;
+    while( i < na && j < nb )
+    {
+        bool takeA;
+        if( ha != hb )
+            takeA = ha > hb;
+        else
+        {
+            size_t h = ha;
+            int order = compareFromLcp( *a[ i ], *b[ j ], h );
+            takeA = descending ? order >= 0 : order <= 0;
+            if( takeA )
+                hb = h;
+            else
+                ha = h;
+        }
+
+        if( takeA )
+        {
+            out[ k ] = a[ i ];
+            lcpOut[ k++ ] = ha;
+            if( ++i < na )
+                ha = lcpA[ i ];
+        }
+        else
+        {
+            out[ k ] = b[ j ];
+            lcpOut[ k++ ] = hb;
+            if( ++j < nb )
+                hb = lcpB[ j ];
+        }
+    }
+    for( ; i < na; ++i, ++k )
+    {
+        out[ k ] = a[ i ];
+        lcpOut[ k ] = ha;
+        if( i + 1 < na )
+            ha = lcpA[ i + 1 ];
+    }
+    for( ; j < nb; ++j, ++k )
+    {
+        out[ k ] = b[ j ];
+        lcpOut[ k ] = hb;
+        if( j + 1 < nb )
+            hb = lcpB[ j + 1 ];
+    }
+}
+
+/**
+ * Internal method for lcpMergeSort.
+ * Sorts a[ 0 .. n - 1 ] with its LCPs in lcp, using buffer and
+ * lcpBuffer (n items each) for the merges.
+ */
+inline void lcpMergeSortRange( string **a, size_t *lcp, size_t n,
+                               string **buffer, size_t *lcpBuffer, bool descending )
+{
+    if( n <= STRING_INSERTION_SORT_CUTOFF )
+    {
+        for( size_t p = 1; p < n; ++p )
+        {
+            string *tmp = a[ p ];
+            size_t j;
+            for( j = p; j > 0 && ( descending ? *a[ j - 1 ] < *tmp : *tmp < *a[ j - 1 ] ); --j )
+                a[ j ] = a[ j - 1 ];
+            a[ j ] = tmp;
+        }
+        for( size_t p = 1; p < n; ++p )
+        {
+            lcp[ p ] = 0;
+            compareFromLcp( *a[ p - 1 ], *a[ p ], lcp[ p ] );
+        }
+        return;
+    }
+
+    size_t middle = n / 2;
+    lcpMergeSortRange( a, lcp, middle, buffer, lcpBuffer, descending );
+    lcpMergeSortRange( a + middle, lcp + middle, n - middle, buffer, lcpBuffer, descending );
+    lcpMerge( a, lcp, middle, a + middle, lcp + middle, n - middle, buffer, lcpBuffer, descending );
+    copy( buffer, buffer + n, a );
+    copy( lcpBuffer, lcpBuffer + n, lcp );
+}
+
+/**
+ * LCP merge sort of the strings in first .. last (stable).
+ * Sorts the strings smallest to largest, or largest to smallest if
+ * descending; each string is moved twice.
+ */
+template <typename RandomIt>
+void lcpMergeSort( RandomIt first, RandomIt last, bool descending )
+{
+    size_t n = size_t( last - first );
+    if( n < 2 )
+        return;
+
+    vector<string *> texts( n ), buffer( n );
+    vector<size_t> lcp( n ), lcpBuffer( n );
+    for( size_t i = 0; i < n; ++i )
+        texts[ i ] = &first[ i ];
+    lcpMergeSortRange( texts.data( ), lcp.data( ), n, buffer.data( ), lcpBuffer.data( ), descending );
+    moveStringsInOrder( first, texts.data( ), n, false );
+}
+
+#endif
@@ -0,0 +1,416 @@
+// Benchmark of the sorting algorithms
+/*
+	To execute this program:
+		./benchmark_sorting	[--sizes 10,1000,100000]	[--types int32,int64,double,string,record]
+			[--inputs random,sorted,...]	[--algorithms quicksort,mergeSort,...]
+			[--trials 5]	[--warmup 1]	[--perturbations K]	[--max_memory_mb 2048]
+			[--seed 1]	[--format csv|json]
+		Every option is optional; a list option restricts the run to the given names.
+
+	For every element type, input distribution, size and algorithm it sorts the
+	same generated input --warmup times without measuring, then --trials times,
+	and prints one row with the minimum, 10th percentile, median, 90th percentile
+	and maximum time of one sort and the median throughput in elements per second.
+	Inputs smaller than 65536 items are sorted in batches of copies per trial, so
+	that each measurement is long enough for the clock.
+	The inputs are generated from --seed, so two runs (e.g. of two releases) sort
+	the same data and their CSV or JSON output can be diffed.
+	Configurations needing more than --max_memory_mb are skipped (noted on stderr).
+
+	Input distributions:
+		random			uniform 31-bit keys
+		sorted			0, 1, 2, ...
+		reverse			n, n - 1, ...
+		organ_pipe		increasing to the middle, then decreasing
+		sawtooth		8 increasing runs
+		few_unique		16 distinct keys
+		all_equal		one key
+		mostly_sorted	sorted, then --perturbations random swaps (default 1% of n)
+	Element types: int32, int64, double, string (14 characters) and
+	record (a 128-byte struct with a 64-bit key).
+*/
+#include "Sort.h"
+#include "ParallelSort.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+namespace {
+
+// A large element: a 64-bit key and a payload, 128 bytes.
+struct BenchRecord {
+	int64_t key;
+	char payload[120];
+};
+
+struct CompareRecords {
+	bool operator()(const BenchRecord &x, const BenchRecord &y) const {
+		return x.key < y.key;
+	}
+};
+
+// The comparator each element type is sorted with.
+template <typename T>
+struct Order {
+	typedef less<T> type;
+};
+
+template <>
+struct Order<BenchRecord> {
+	typedef CompareRecords type;
+};
+
+// Converts a generated key to an element; the order of the keys is kept.
+template <typename T>
+T MakeItem(long long key) {
+	return T(key);
+}
+
+template <>
+string MakeItem<string>(long long key) {
+	char text[32];
+	snprintf(text, sizeof(text), "key-%010lld", key);
+	return text;
+}
+
+template <>
+BenchRecord MakeItem<BenchRecord>(long long key) {
+	BenchRecord record{};
+	record.key = key;
+	return record;
+}
+
+const vector<string> ALL_INPUTS = {"random", "sorted", "reverse", "organ_pipe", "sawtooth",
+                                   "few_unique", "all_equal", "mostly_sorted"};
+const vector<string> ALL_TYPES = {"int32", "int64", "double", "string", "record"};
+
+// Items sorted per measurement at least (small inputs are sorted in batches).
+const size_t BATCH_ITEMS = 1 << 16;
+
+struct Options {
+	vector<long long> sizes = {10, 1000, 100000};
+	vector<string> types = ALL_TYPES;
+	vector<string> inputs = ALL_INPUTS;
+	vector<string> algorithms;     // Empty: all of them
+	int trials = 5;
+	int warmup = 1;
+	long long perturbations = -1;  // -1: 1% of the size
+	long long max_memory_mb = 2048;
+	unsigned long long seed = 1;
+	string format = "csv";
+};
+
+// One algorithm: its name and how it sorts a vector of T.
+template <typename T>
+struct Algorithm {
+	string name;
+	function<void(vector<T> &)> sort;
+};
+
+// The algorithms benchmarked for T; radix sort only for integers, the string engines only for strings.
+template <typename T>
+vector<Algorithm<T>> Algorithms() {
+	typedef typename Order<T>::type Compare;
+	vector<Algorithm<T>> list = {
+		{"quicksort", [](vector<T> &a) { quicksort(a, Compare{}); }},
+		{"quicksortMiddle", [](vector<T> &a) { quicksortMiddle(a, Compare{}); }},
+		{"quicksortFirst", [](vector<T> &a) { quicksortFirst(a, Compare{}); }},
+		{"SORT", [](vector<T> &a) { SORT(a, Compare{}); }},
+		{"mergeSort", [](vector<T> &a) { mergeSort(a, Compare{}); }},
+		{"mergeSortBottomUp", [](vector<T> &a) { mergeSortBottomUp(a, Compare{}); }},
+		{"timSort", [](vector<T> &a) { timSort(a, Compare{}); }},
+		{"heapsort", [](vector<T> &a) { heapsort(a, Compare{}); }},
+		{"dAryHeapsort4", [](vector<T> &a) { dAryHeapsort<4>(a, Compare{}); }},
+		{"parallelQuicksort", [](vector<T> &a) { parallelQuicksort(a, Compare{}); }},
+		{"parallelMergeSort", [](vector<T> &a) { parallelMergeSort(a, Compare{}); }},
+		{"dispatchSort", [](vector<T> &a) { dispatchSort(a, Compare{}); }},
+		{"dispatchStableSort", [](vector<T> &a) { dispatchStableSort(a, Compare{}); }},
+	};
+	if constexpr (is_integral<T>::value)
+		list.push_back({"radixSort", [](vector<T> &a) { radixSort(a, Compare{}); }});
+	if constexpr (is_same<T, string>::value) {
+		list.push_back({"stringSort", [](vector<T> &a) { stringSort(a, Compare{}); }});
+		list.push_back({"stableStringSort", [](vector<T> &a) { stableStringSort(a, Compare{}); }});
+	}
+	return list;
+}
+
+// Generates @n keys of the distribution @input.
+vector<long long> GenerateKeys(const string &input, size_t n, long long perturbations, mt19937_64 &rng) {
+	vector<long long> keys(n);
+	for (size_t i = 0; i < n; ++i) {
+		if (input == "random")
+			keys[i] = rng() >> 33;
+		else if (input == "reverse")
+			keys[i] = n - i;
+		else if (input == "organ_pipe")
+			keys[i] = i < n / 2 ? i : n - i;
+		else if (input == "sawtooth")
+			keys[i] = i % max<size_t>(1, (n + 7) / 8);
+		else if (input == "few_unique")
+			keys[i] = rng() % 16;
+		else if (input == "all_equal")
+			keys[i] = 42;
+		else  // sorted, mostly_sorted
+			keys[i] = i;
+	}
+	if (input == "mostly_sorted" && n > 1) {
+		const long long swaps = perturbations >= 0 ? perturbations : max<long long>(1, n / 100);
+		for (long long s = 0; s < swaps; ++s)
+			swap(keys[rng() % n], keys[rng() % n]);
+	}
+	return keys;
+}
+
+// The value at rank @p percent of the sorted @times (nearest rank).
+double Percentile(const vector<double> &times, double p) {
+	size_t rank = (size_t) (p / 100 * times.size() + 0.5);
+	return times[min(times.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+// Statistics of the trials of one configuration.
+struct Result {
+	string algorithm, type, input;
+	long long size;
+	int trials;
+	double min_ns, p10_ns, median_ns, p90_ns, max_ns, elements_per_s;
+	bool verified;
+};
+
+/**
+ * Sorts @input with @algorithm @warmup + @trials times.
+ * Each trial sorts enough copies of @input to cover BATCH_ITEMS items and
+ * records the time of one sort. Verifies the order of the first sorted copy.
+ */
+template <typename T>
+Result Measure(const Algorithm<T> &algorithm, const vector<T> &input, const Options &options) {
+	typedef typename Order<T>::type Compare;
+	const size_t batch = max<size_t>(1, BATCH_ITEMS / max<size_t>(1, input.size()));
+	vector<double> times;
+	bool verified = true;
+	for (int trial = -options.warmup; trial < options.trials; ++trial) {
+		vector<vector<T>> copies(batch, input);
+		const auto begin = chrono::steady_clock::now();
+		// Time this piece of code.
+		for (vector<T> &copy : copies)
+			algorithm.sort(copy);
+		// End of piece of code to time.
+		const auto end = chrono::steady_clock::now();
+		verified = verified && is_sorted(copies[0].begin(), copies[0].end(), Compare{});
+		if (trial >= 0)
+			times.push_back((double) chrono::duration_cast<chrono::nanoseconds>(end - begin).count() / batch);
+	}
+	std::sort(times.begin(), times.end());
+
+	Result result;
+	result.algorithm = algorithm.name;
+	result.size = input.size();
+	result.trials = options.trials;
+	result.min_ns = times.front();
+	result.p10_ns = Percentile(times, 10);
+	result.median_ns = Percentile(times, 50);
+	result.p90_ns = Percentile(times, 90);
+	result.max_ns = times.back();
+	result.elements_per_s = result.median_ns > 0 ? input.size() / (result.median_ns * 1e-9) : 0;
+	result.verified = verified;
+	return result;
+}
+
+// Whether @name is in @names.
+bool Contains(const vector<string> &names, const string &name) {
+	return find(names.begin(), names.end(), name) != names.end();
+}
+
+/**
+ * Runs every selected input distribution, size and algorithm for the
+ * element type T (named @type_name) and appends the results.
+ */
+template <typename T>
+void RunType(const string &type_name, const Options &options, vector<Result> &results) {
+	const vector<Algorithm<T>> algorithms = Algorithms<T>();
+	for (const string &input_name : options.inputs) {
+		for (long long size : options.sizes) {
+				// Input, copies of the batch and a merge buffer
+			const long long batch_items = max<long long>(size, BATCH_ITEMS);
+			const long long bytes = (long long) sizeof(T) * (size + 2 * batch_items) + 8 * size;
+			if (bytes > options.max_memory_mb << 20) {
+				cerr << "Skipped " << type_name << " " << input_name << " " << size
+				     << ": needs about " << (bytes >> 20) << "MB (--max_memory_mb)" << endl;
+				continue;
+			}
+			mt19937_64 rng(options.seed);
+			const vector<long long> keys = GenerateKeys(input_name, size, options.perturbations, rng);
+			vector<T> input;
+			input.reserve(size);
+			for (long long key : keys)
+				input.push_back(MakeItem<T>(key));
+
+			for (const Algorithm<T> &algorithm : algorithms) {
+				if (!options.algorithms.empty() && !Contains(options.algorithms, algorithm.name))
+					continue;
+				Result result = Measure(algorithm, input, options);
+				result.type = type_name;
+				result.input = input_name;
+				results.push_back(result);
+				cerr << "." << flush;
+			}
+		}
+	}
+}
+
+// Prints @results as CSV with a header line.
+void PrintCsv(const vector<Result> &results) {
+	cout << "algorithm,type,input,size,trials,min_ns,p10_ns,median_ns,p90_ns,max_ns,elements_per_s,verified" << endl;
+	for (const Result &r : results) {
+		char line[512];
+		snprintf(line, sizeof(line), "%s,%s,%s,%lld,%d,%.1f,%.1f,%.1f,%.1f,%.1f,%.0f,%d",
+		         r.algorithm.c_str(), r.type.c_str(), r.input.c_str(), r.size, r.trials,
+		         r.min_ns, r.p10_ns, r.median_ns, r.p90_ns, r.max_ns, r.elements_per_s, r.verified);
+		cout << line << endl;
+	}
+}
+
+// Prints @results as a JSON array with one object per line.
+void PrintJson(const vector<Result> &results) {
+	cout << "[" << endl;
+	for (size_t i = 0; i < results.size(); ++i) {
+		const Result &r = results[i];
+		char line[512];
+		snprintf(line, sizeof(line),
+		         "  {\"algorithm\": \"%s\", \"type\": \"%s\", \"input\": \"%s\", \"size\": %lld, \"trials\": %d, "
+		         "\"min_ns\": %.1f, \"p10_ns\": %.1f, \"median_ns\": %.1f, \"p90_ns\": %.1f, \"max_ns\": %.1f, "
+		         "\"elements_per_s\": %.0f, \"verified\": %s}%s",
+		         r.algorithm.c_str(), r.type.c_str(), r.input.c_str(), r.size, r.trials,
+		         r.min_ns, r.p10_ns, r.median_ns, r.p90_ns, r.max_ns, r.elements_per_s,
+		         r.verified ? "true" : "false", i + 1 < results.size() ? "," : "");
+		cout << line << endl;
+	}
+	cout << "]" << endl;
+}
+
+// Splits the comma-separated list @text.
+vector<string> SplitList(const string &text) {
+	vector<string> items;
+	stringstream stream(text);
+	string item;
+	while (getline(stream, item, ','))
+		if (!item.empty())
+			items.push_back(item);
+	return items;
+}
+
+// Parses the command line into @options; returns false (after printing why) on an error.
+bool ParseOptions(int argc, char **argv, Options &options) {
+	for (int i = 1; i < argc; i += 2) {
+		const string name = argv[i];
+		if (i + 1 >= argc) {
+			cout << "Missing value for " << name << endl;
+			return false;
+		}
+		const string value = argv[i + 1];
+		if (name == "--sizes") {
+			options.sizes.clear();
+			for (const string &size : SplitList(value))
+				options.sizes.push_back(stoll(size));
+		} else if (name == "--types") {
+			options.types = SplitList(value);
+		} else if (name == "--inputs") {
+			options.inputs = SplitList(value);
+		} else if (name == "--algorithms") {
+			options.algorithms = SplitList(value);
+		} else if (name == "--trials") {
+			options.trials = stoi(value);
+		} else if (name == "--warmup") {
+			options.warmup = stoi(value);
+		} else if (name == "--perturbations") {
+			options.perturbations = stoll(value);
+		} else if (name == "--max_memory_mb") {
+			options.max_memory_mb = stoll(value);
+		} else if (name == "--seed") {
+			options.seed = stoull(value);
+		} else if (name == "--format") {
+			options.format = value;
+		} else {
+			cout << "Unknown option " << name << endl;
+			return false;
+		}
+	}
+
+	for (long long size : options.sizes)
+		if (size < 1 || size > INT32_MAX) {
+			cout << "Invalid size " << size << " (1 to 2^31 - 1)" << endl;
+			return false;
+		}
+	for (const string &type : options.types)
+		if (!Contains(ALL_TYPES, type)) {
+			cout << "Invalid type " << type << endl;
+			return false;
+		}
+	for (const string &input : options.inputs)
+		if (!Contains(ALL_INPUTS, input)) {
+			cout << "Invalid input " << input << endl;
+			return false;
+		}
+	for (const string &algorithm : options.algorithms) {
+		bool known = false;
+		for (const Algorithm<int64_t> &a : Algorithms<int64_t>())
+			known = known || a.name == algorithm;
+		for (const Algorithm<string> &a : Algorithms<string>())
+			known = known || a.name == algorithm;
+		if (!known) {
+			cout << "Invalid algorithm " << algorithm << endl;
+			return false;
+		}
+	}
+	if (options.trials < 1 || options.warmup < 0) {
+		cout << "Invalid number of trials or warm-ups" << endl;
+		return false;
+	}
+	if (options.format != "csv" && options.format != "json") {
+		cout << "Invalid format" << endl;
+		return false;
+	}
+	return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+	Options options;
+	if (!ParseOptions(argc, argv, options)) {
+		cout << "Usage: " << argv[0] << " [--sizes 10,1000,100000] [--types int32,int64,double,string,record]"
+		     << " [--inputs random,sorted,reverse,organ_pipe,sawtooth,few_unique,all_equal,mostly_sorted]"
+		     << " [--algorithms quicksort,mergeSort,...] [--trials 5] [--warmup 1] [--perturbations K]"
+		     << " [--max_memory_mb 2048] [--seed 1] [--format csv|json]" << endl;
+		return 0;
+	}
+
+	vector<Result> results;
+	for (const string &type : options.types) {
+		if (type == "int32")
+			RunType<int32_t>(type, options, results);
+		else if (type == "int64")
+			RunType<int64_t>(type, options, results);
+		else if (type == "double")
+			RunType<double>(type, options, results);
+		else if (type == "string")
+			RunType<string>(type, options, results);
+		else
+			RunType<BenchRecord>(type, options, results);
+	}
+	cerr << endl;
+
+	if (options.format == "json")
+		PrintJson(results);
+	else
+		PrintCsv(results);
+	return 0;
+}
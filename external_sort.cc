@@ -0,0 +1,77 @@
+// External sort
+// Sorts a binary file of 32-bit integers that may be larger than memory
+/*
+	To execute this program:
+		./external_sort	<input_file>	<output_file>	<memory_budget_MB>	<comparison_type>	[temp_dir]
+		the files hold native-endian 32-bit signed integers
+		comparison_type can be "less" or "greater"
+		temp_dir holds the sorted runs (default /tmp)
+
+	The input is sorted in chunks of the memory budget, the sorted runs are
+	spilled to temp_dir and then merged into the output file (ExternalSort.h).
+	Prints the number of runs, merge passes and how long it took.
+*/
+#include "ExternalSort.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+using namespace std;
+
+namespace {
+
+/**
+ * Sorts @input_file into @output_file with externalSort and prints what it did
+ */
+template <typename Comparator>
+int RunExternalSort(const string &input_file, const string &output_file, size_t memory_budget,
+		const string &temp_dir, Comparator compare) {
+	try {
+		const auto begin = chrono::high_resolution_clock::now();
+		// Time this piece of code.
+		const ExternalSortStats stats =
+			externalSort<int32_t>(input_file, output_file, compare, memory_budget, temp_dir);
+		// End of piece of code to time.
+		const auto end = chrono::high_resolution_clock::now();
+		cout << "Records: " << stats.records << endl;
+		cout << "Runs: " << stats.runs << " Merge passes: " << stats.mergePasses << endl;
+		cout << "Run time: ";
+		cout << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms" << endl;
+	} catch (const exception &error) {
+		cout << "External sort failed: " << error.what() << endl;
+		return 1;
+	}
+	return 0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+	if (argc != 5 && argc != 6) {
+		cout << "Usage: " << argv[0]
+			<< " <input_file> <output_file> <memory_budget_MB> <comparison_type> [temp_dir]" << endl;
+		return 0;
+	}
+	const string input_file = string(argv[1]);
+	const string output_file = string(argv[2]);
+	const long long memory_budget_mb = stoll(string(argv[3]));
+	const string comparison_type = string(argv[4]);
+	const string temp_dir = argc == 6 ? string(argv[5]) : string("/tmp");
+	if (memory_budget_mb <= 0) {
+		cout << "Invalid memory budget" << endl;
+		return 0;
+	}
+	if (comparison_type != "less" && comparison_type != "greater") {
+		cout << "Invalid comparison type" << endl;
+		return 0;
+	}
+
+	const size_t memory_budget = (size_t) memory_budget_mb << 20;
+	cout << "External sort: " << input_file << " -> " << output_file << " "
+		<< memory_budget_mb << "MB " << comparison_type << endl;
+	if (comparison_type == "greater")
+		return RunExternalSort(input_file, output_file, memory_budget, temp_dir, greater<int32_t>{});
+	return RunExternalSort(input_file, output_file, memory_budget, temp_dir, less<int32_t>{});
+}
@@ -0,0 +1,154 @@
+// Part III
+// Testing the external sort
+/*
+	To execute this function:
+		./test_external_sort	<input_size>	<memory_budget_KB>	<comparison_type>
+		comparison_type can be "less" or "greater"
+
+	This function writes <input_size> random 32-bit integers to a file in /tmp
+	and sorts it with externalSort (ExternalSort.h) using a memory budget of
+	<memory_budget_KB> KB, which should be smaller than the file
+	(4 * <input_size> bytes) so the sort has to spill runs and merge them.
+	It prints the number of runs and merge passes, how long the sort took,
+	1 for verified order if the output file is sorted, and 1 if the output
+	holds the same numbers as the input sorted in memory.
+	It also checks that memory budgets above INT_MAX records are capped to
+	chunks the in-memory sort can index.
+*/
+#include "ExternalSort.h"
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+using namespace std;
+
+namespace {
+
+// Generates and returns random vector of size @size_of_vector.
+vector<int32_t> GenerateRandomVector(size_t size_of_vector) {
+	vector<int32_t> a;
+	for (size_t i = 0; i < size_of_vector; ++i)
+		a.push_back(rand());
+	return a;
+}
+
+// Writes @a to the binary file @path
+void WriteFile(const string &path, const vector<int32_t> &a) {
+	RecordFile file(path, O_WRONLY | O_CREAT | O_TRUNC);
+	file.write(a.data(), a.size() * sizeof(int32_t));
+}
+
+// Reads the binary file @path
+vector<int32_t> ReadFile(const string &path) {
+	RecordFile file(path, O_RDONLY);
+	vector<int32_t> a(file.size() / sizeof(int32_t));
+	file.read(a.data(), a.size() * sizeof(int32_t));
+	return a;
+}
+
+/**
+ * Check if a vector is in order (from smallest to largest or from largest to smallest)
+ * @return true if vector is in order, otherwise return false
+ */
+template <typename Comparable, typename Comparator>
+bool VerifyOrder(const vector<Comparable> &input, Comparator compare) {
+	for (size_t i = 1; i < input.size(); i++)
+		if (compare(input[i], input[i - 1])) // return false if invalid order is detected
+			return false;
+	return true;
+}
+
+/**
+ * Sorts the file @input_path into @output_path with externalSort
+ * Prints runs, merge passes, run time, verified order and whether the
+ * output matches @input sorted in memory
+ */
+template <typename Comparator>
+void ExternalSortTest(const vector<int32_t> &input, const string &input_path, const string &output_path,
+		size_t memory_budget, Comparator compare) {
+	const auto begin = chrono::high_resolution_clock::now();
+	// Time this piece of code.
+	const ExternalSortStats stats = externalSort<int32_t>(input_path, output_path, compare, memory_budget);
+	// End of piece of code to time.
+	const auto end = chrono::high_resolution_clock::now();
+	cout << "Runs: " << stats.runs << " Merge passes: " << stats.mergePasses << endl;
+	cout << "Run time: ";
+	cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() << "ns";
+	cout << " or ";
+	cout << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms" << endl;
+
+	const vector<int32_t> output = ReadFile(output_path);
+	vector<int32_t> expected = input;
+	quicksort(expected, compare);
+	cout << "Verified: " << VerifyOrder(output, compare) << endl;
+	cout << "Matches in-memory sort: " << (output == expected) << endl;
+}
+
+/**
+ * Checks that budgets for more records than quicksort can index (an int)
+ * are capped at EXTERNAL_SORT_MAX_CHUNK records per in-memory chunk.
+ * Prints 1 for verified if every budget gives the expected chunk.
+ */
+void ChunkCapTest() {
+	const size_t big = (size_t) 1 << 36;  // 64GB
+	const bool verified = externalSortChunkRecords(1 << 20, sizeof(int32_t)) == (1 << 18)
+		&& externalSortChunkRecords(big, sizeof(int32_t)) == (size_t) INT_MAX
+		&& externalSortChunkRecords(((size_t) 1 << 31) + 4096, sizeof(uint8_t)) == (size_t) INT_MAX
+		&& externalSortChunkRecords(big, 64) == big / 64;
+	cout << "Chunk cap (" << EXTERNAL_SORT_MAX_CHUNK << " records) Verified: " << verified << endl;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+	if (argc != 4) {
+		cout << "Usage: " << argv[0] << " <input_size> <memory_budget_KB> <comparison_type>" << endl;
+		return 0;
+	}
+	const int input_size = stoi(string(argv[1]));
+	const int memory_budget_kb = stoi(string(argv[2]));
+	const string comparison_type = string(argv[3]);
+	if (input_size <= 0) {
+		cout << "Invalid size" << endl;
+		return 0;
+	}
+	if (memory_budget_kb <= 0) {
+		cout << "Invalid memory budget" << endl;
+		return 0;
+	}
+	if (comparison_type != "less" && comparison_type != "greater") {
+		cout << "Invalid comparison type" << endl;
+		return 0;
+	}
+
+	const size_t memory_budget = (size_t) memory_budget_kb << 10;
+	const size_t file_size = (size_t) input_size * sizeof(int32_t);
+	cout << "Testing external sort: " << input_size << " numbers (" << file_size / 1024 << "KB) with a "
+		<< memory_budget_kb << "KB memory budget " << comparison_type << endl;
+	if (file_size <= memory_budget)
+		cout << "Note: the file fits in the budget, nothing is merged" << endl;
+
+	const string input_path = "/tmp/test_external_sort-" + to_string(getpid()) + ".in";
+	const string output_path = "/tmp/test_external_sort-" + to_string(getpid()) + ".out";
+	const vector<int32_t> input_vector = GenerateRandomVector(input_size);
+	cout << "-----------------" << endl;
+	try {
+		WriteFile(input_path, input_vector);
+		if (comparison_type == "greater")
+			ExternalSortTest(input_vector, input_path, output_path, memory_budget, greater<int32_t>{});
+		else
+			ExternalSortTest(input_vector, input_path, output_path, memory_budget, less<int32_t>{});
+	} catch (const exception &error) {
+		cout << "External sort failed: " << error.what() << endl;
+	}
+	ChunkCapTest();
+	unlink(input_path.c_str());
+	unlink(output_path.c_str());
+	return 0;
+}
@@ -11,12 +11,31 @@
 		b) Middle pivot (always	select	the	middle item in	the	array)
 		c) First pivot (always	select	the	first item in	the	array)
 	This function prints 1 for verified order if vector is sorted after sorting.
-	Also prints how long each sorting method takes to sort the vector
+	Also prints how long each sorting method takes to sort the vector, and the
+	comparisons, moves, swaps, recursion depth and partition balance counted
+	by a separate instrumented sort of the same input.
+	Where Linux hardware counters are available it prints the cycles,
+	instructions, branch misses, L1D/LLC/dTLB misses per element and the IPC
+	of each timed sort.
+	Then it sorts the original input with each pivot twice, once with the Hoare
+	partition loop and once with the branchless block partition.
+	It finds the p50/p90/p99/p99.9 items with multiSelect and the first 100
+	items with partialSort, and checks them against a full sort.
+	Finally it sorts the original input with the parallel quicksort using
+	1, 2, 4, ... threads (up to the number of cores) and prints the speedup,
+	and counts the comparisons of quicksort and the parallel quicksort on
+	McIlroy's adversary, which drives a plain quicksort quadratic.
+	Last it sorts the input as uint32_t, float and int16_t items, whose
+	leaves use the SIMD sorting networks as well.
 */
 
 #include "Sort.h"
+#include "ParallelSort.h"
+#include "PerfCounters.h"
+#include <algorithm>
 #include <chrono>
 #include <iostream>
+#include <mutex>
 #include <fstream>
 #include <functional>
 #include <string>
@@ -65,6 +84,59 @@ bool VerifyOrder(const vector<Comparable> &input, Comparator compare) {
 	return true;
 }
 
+/**
+ * Sorts a copy of @a made of Tracked items with @sort and @compare instrumented
+ * (not timed: the counting slows the sort down)
+ * The counts describe the scalar path: Tracked items have no sorting network,
+ * so the quicksorts stop at INSERTION_SORT_CUTOFF and finish with insertion
+ * sort, where the timed sort of int stops at up to 32 items and finishes with
+ * the SIMD network.
+ * @return the comparisons, moves, swaps, recursion depth and partition balance
+ */
+template <typename Comparable, typename Comparator, typename Sorter>
+SortStats CountOperations(const vector<Comparable> &a, Comparator compare, Sorter sort) {
+	vector<Tracked<Comparable>> items(a.begin(), a.end());
+	SortStats stats;
+	TrackMoves track_moves(stats);
+	sort(items, instrument(compare, stats));
+	return stats;
+}
+
+// Prints the counts of @stats (the partition balance only if there were partitions)
+void PrintCounts(const SortStats &stats) {
+	cout << "Scalar path, comparisons: " << stats.comparisons << " Moves: " << stats.moves
+		<< " Swaps: " << stats.swaps << " Max depth: " << stats.maxDepth << endl;
+	long long partitions = 0;
+	for (long long count : stats.partitionBalance)
+		partitions += count;
+	if (partitions == 0)
+		return;
+	cout << "Partition balance (smaller side 0-10%, 10-20%, 20-30%, 30-40%, 40-50%):";
+	for (long long count : stats.partitionBalance)
+		cout << " " << count;
+	cout << endl;
+}
+
+// Hardware counters of this thread, opened once (PerfCounters.h)
+PerfCounters &Counters() {
+	static PerfCounters counters;
+	return counters;
+}
+
+// Prints @counts per element of the @n sorted items, and the IPC
+// (nothing if no counter is available: timing only)
+void PrintPerfCounts(const PerfCounts &counts, size_t n) {
+	if (!counts.any() || n == 0)
+		return;
+	cout << "Per element:";
+	for (int event = 0; event < PERF_EVENT_COUNT; ++event)
+		if (counts.counted[event])
+			cout << " " << perfEventName(event) << ": " << (double) counts.value[event] / n;
+	if (counts.ipc() > 0)
+		cout << " IPC: " << counts.ipc();
+	cout << endl;
+}
+
 /**
  * Signature for quicksort (choose median of first, middle, last of vector as pivot)
  * Prints how long it takes to sort a vector
@@ -74,15 +146,20 @@ void QuickSort1(vector<Comparable> &a, Comparator compare) {
 	// pivot is the median of the three
 	cout << "[ Median of three ]" << endl;
 	
+	const SortStats stats = CountOperations(a, compare, [](auto &items, auto counted) { quicksort(items, counted); });
 	cout << "Run time: ";
+	Counters().start();
 	const auto begin = chrono::high_resolution_clock::now();
 	// Time this piece of code.
 	quicksort(a, compare);
 	// End of piece of code to time.
 	const auto end = chrono::high_resolution_clock::now();    
+	const PerfCounts counts = Counters().stop();
 	cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() << "ns";
 	cout << " or ";
 	cout << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms" << endl;
+	PrintCounts(stats);
+	PrintPerfCounts(counts, a.size());
 	
 }
 
@@ -95,15 +172,20 @@ void QuickSort2(vector<Comparable> &a, Comparator compare) {
 	// pivot is the middle element of the array
 	cout << "[ Middle ]" << endl;
 	
+	const SortStats stats = CountOperations(a, compare, [](auto &items, auto counted) { quicksortMiddle(items, counted); });
 	cout << "Run time: ";
+	Counters().start();
 	const auto begin = chrono::high_resolution_clock::now();
 	// Time this piece of code.
 	quicksortMiddle(a, compare);	
 	// End of piece of code to time.
 	const auto end = chrono::high_resolution_clock::now();    
+	const PerfCounts counts = Counters().stop();
 	cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() << "ns";
 	cout << " or ";
 	cout << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms" << endl;
+	PrintCounts(stats);
+	PrintPerfCounts(counts, a.size());
 }
 
 /**
@@ -115,15 +197,225 @@ void QuickSort3(vector<Comparable> &a, Comparator compare) {
 	// pivot is the first element of the array
 	cout << "[ First ]" << endl;
 	
+	const SortStats stats = CountOperations(a, compare, [](auto &items, auto counted) { quicksortFirst(items, counted); });
 	cout << "Run time: ";
+	Counters().start();
 	const auto begin = chrono::high_resolution_clock::now();
 	// Time this piece of code.
 	quicksortFirst(a, compare);
 	// End of piece of code to time.
 	const auto end = chrono::high_resolution_clock::now();    
+	const PerfCounts counts = Counters().stop();
 	cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() << "ns";
 	cout << " or ";
 	cout << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms" << endl;
+	PrintCounts(stats);
+	PrintPerfCounts(counts, a.size());
+}
+
+/**
+ * Sorts a copy of @input with introsort<PivotPolicy, PartitionScheme>
+ * Prints how long it takes to sort, whether the result is in order and the operation counts
+ */
+template <typename PivotPolicy, typename PartitionScheme, typename Comparable, typename Comparator>
+void TimePartition(const string &name, const vector<Comparable> &input, Comparator compare) {
+	vector<Comparable> a = input;
+	const SortStats stats = CountOperations(a, compare,
+		[](auto &items, auto counted) { introsort<PivotPolicy, PartitionScheme>(items, counted); });
+	Counters().start();
+	const auto begin = chrono::high_resolution_clock::now();
+	// Time this piece of code.
+	introsort<PivotPolicy, PartitionScheme>(a, compare);
+	// End of piece of code to time.
+	const auto end = chrono::high_resolution_clock::now();
+	const PerfCounts counts = Counters().stop();
+	cout << name << " Run time: ";
+	cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() << "ns";
+	cout << " or ";
+	cout << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms";
+	cout << " Verified: " << VerifyOrder(a, compare) << endl;
+	PrintCounts(stats);
+	PrintPerfCounts(counts, a.size());
+}
+
+/**
+ * Sorts copies of @input with each pivot, using the Hoare partition loop
+ * (branches on every comparison) and the block partition (branchless)
+ */
+template <typename Comparable, typename Comparator>
+void PartitionComparison(const vector<Comparable> &input, Comparator compare) {
+	cout << "[ Hoare vs block partition ]" << endl;
+	TimePartition<MedianOfThreePivot, HoarePartition>("Median of three, Hoare:", input, compare);
+	TimePartition<MedianOfThreePivot, BlockPartition>("Median of three, block:", input, compare);
+	TimePartition<MiddlePivot, HoarePartition>("Middle, Hoare:", input, compare);
+	TimePartition<MiddlePivot, BlockPartition>("Middle, block:", input, compare);
+	TimePartition<FirstPivot, HoarePartition>("First, Hoare:", input, compare);
+	TimePartition<FirstPivot, BlockPartition>("First, block:", input, compare);
+}
+
+/**
+ * Finds the p50, p90, p99 and p99.9 items of a copy of @input with multiSelect
+ * and the first 100 items in order with partialSort.
+ * Prints the percentiles, run times and whether both match a full sort.
+ */
+template <typename Comparable, typename Comparator>
+void Selection(const vector<Comparable> &input, Comparator compare) {
+	cout << "[ Selection ]" << endl;
+	vector<Comparable> sorted = input;
+	quicksort(sorted, compare);
+	const int n = input.size();
+	const vector<double> percentiles = {50, 90, 99, 99.9};
+	vector<int> ranks;
+	for (double p : percentiles)
+		ranks.push_back(max(1, (int) (p / 100 * n + 0.5)));
+
+	vector<Comparable> a = input;
+	auto begin = chrono::high_resolution_clock::now();
+	// Time this piece of code.
+	multiSelect(a, ranks, compare);
+	// End of piece of code to time.
+	auto end = chrono::high_resolution_clock::now();
+	bool verified = true;
+	for (size_t i = 0; i < ranks.size(); ++i) {
+		cout << "p" << percentiles[i] << ": " << a[ranks[i] - 1] << " ";
+		verified = verified && a[ranks[i] - 1] == sorted[ranks[i] - 1];
+	}
+	cout << endl << "multiSelect Run time: ";
+	cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() << "ns";
+	cout << " or ";
+	cout << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms";
+	cout << " Verified: " << verified << endl;
+
+	const int k = min(100, n);
+	a = input;
+	begin = chrono::high_resolution_clock::now();
+	// Time this piece of code.
+	partialSort(a, k, compare);
+	// End of piece of code to time.
+	end = chrono::high_resolution_clock::now();
+	cout << "partialSort (" << k << " items) Run time: ";
+	cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() << "ns";
+	cout << " or ";
+	cout << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms";
+	cout << " Verified: " << equal(a.begin(), a.begin() + k, sorted.begin()) << endl;
+}
+
+/**
+ * McIlroy's adversary ("A Killer Adversary for Quicksort"): a comparator
+ * that fixes the values of the items only as the sort compares them, so
+ * that every pivot it picks ends up near the smallest item. A plain
+ * quicksort makes about n^2 / 4 comparisons against it.
+ */
+struct AntiQuicksort {
+	mutex *lock;            // The sorting threads share the fixed values
+	vector<int> *value;
+	int gas;                // Value of the items not fixed yet
+	int *solid;             // Number of items fixed
+	int *candidate;
+	long long *comparisons;
+
+	bool operator()(int x, int y) const {
+		lock_guard<mutex> guard(*lock);
+		++*comparisons;
+		vector<int> &v = *value;
+		if (v[x] == gas && v[y] == gas)
+			v[x == *candidate ? x : y] = (*solid)++;
+		if (v[x] == gas)
+			*candidate = x;
+		else if (v[y] == gas)
+			*candidate = y;
+		return v[x] < v[y];
+	}
+};
+
+/**
+ * Sorts @n items with @sort against AntiQuicksort.
+ * @return the comparisons it made
+ */
+template <typename Sorter>
+long long AdversaryComparisons(int n, Sorter sort) {
+	mutex lock;
+	vector<int> value(n, n), items(n);
+	int solid = 0, candidate = 0;
+	long long comparisons = 0;
+	for (int i = 0; i < n; ++i)
+		items[i] = i;
+	sort(items, AntiQuicksort{&lock, &value, n, &solid, &candidate, &comparisons});
+	return comparisons;
+}
+
+/**
+ * Sorts a copy of @input with parallelQuicksort for 1, 2, 4, ... threads
+ * up to the number of hardware threads.
+ * Prints run time, speedup over one thread and verified order for each count.
+ */
+template <typename Comparable, typename Comparator>
+void ParallelQuickSortScaling(const vector<Comparable> &input, Comparator compare) {
+	cout << "[ Parallel median of three ]" << endl;
+
+	const int max_threads = defaultThreadCount();
+	vector<int> thread_counts;
+	for (int t = 1; t < max_threads; t *= 2)
+		thread_counts.push_back(t);
+	thread_counts.push_back(max_threads);
+
+	long long single_thread_ns = 0;
+	for (int threads : thread_counts) {
+		vector<Comparable> a = input;
+		const auto begin = chrono::high_resolution_clock::now();
+		// Time this piece of code.
+		parallelQuicksort(a, compare, threads);
+		// End of piece of code to time.
+		const auto end = chrono::high_resolution_clock::now();
+		const long long ns = chrono::duration_cast<chrono::nanoseconds>(end - begin).count();
+		if (threads == 1)
+			single_thread_ns = ns;
+
+		cout << "Threads: " << threads << " Run time: " << ns << "ns";
+		cout << " or ";
+		cout << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms";
+		cout << " Speedup: " << (ns > 0 ? (double) single_thread_ns / ns : 0.0);
+		cout << " Verified: " << VerifyOrder(a, compare) << endl;
+	}
+
+	// Both must stay O(n log n); threads interleaving weakens the adversary
+	const int n = min<int>(input.size(), 1 << 17);
+	const long long serial = AdversaryComparisons(n, [](auto &items, auto adversary) { quicksort(items, adversary); });
+	const long long parallel = AdversaryComparisons(n, [](auto &items, auto adversary) {
+		parallelQuicksort(items, adversary, 2, 1024);
+	});
+	cout << "Adversary, " << n << " items: quicksort " << serial << " and 2 threads " << parallel
+	     << " comparisons Verified: " << (parallel <= 2 * serial) << endl;
+}
+
+/**
+ * Sorts @input converted to Item (shifted so that half of it is negative)
+ * with quicksort and with std::sort, in the order of @compare.
+ * @return true if both give the same items
+ */
+template <typename Item, typename Comparator>
+bool LeafTypeSort(const vector<int> &input, Comparator) {
+	typedef typename conditional<is_same<Comparator, greater<int>>::value, greater<Item>, less<Item>>::type Order;
+	vector<Item> a;
+	for (int x : input)
+		a.push_back(static_cast<Item>(x) - static_cast<Item>(RAND_MAX / 2));
+	vector<Item> expected = a;
+	quicksort(a, Order{});
+	std::sort(expected.begin(), expected.end(), Order{});
+	return a == expected;
+}
+
+/**
+ * Sorts @input as uint32_t, float and int16_t items, whose quicksort leaves
+ * go through the SIMD networks like those of int.
+ * Prints verified order for each type.
+ */
+template <typename Comparator>
+void NetworkLeafTypes(const vector<int> &input, Comparator compare) {
+	cout << "[ Network leaves ]" << endl;
+	cout << "uint32_t Verified: " << LeafTypeSort<uint32_t>(input, compare) << endl;
+	cout << "float Verified: " << LeafTypeSort<float>(input, compare) << endl;
+	cout << "int16_t Verified: " << LeafTypeSort<int16_t>(input, compare) << endl;
 }
 
 }  // namespace
@@ -152,6 +444,8 @@ int main(int argc, char **argv) {
 	
 	cout << "Testing quicksort: " << input_type << " " << input_size << " numbers " 
 		<< comparison_type << endl;
+	if (!Counters().available())
+		cout << "Hardware counters unavailable: timing only" << endl;
 	vector<int> input_vector;
 	if (input_type == "random") {
 		input_vector = GenerateRandomVector(input_size);
@@ -160,6 +454,7 @@ int main(int argc, char **argv) {
 		for(int i = 0; i < input_size; i++)
 			input_vector.push_back(i);
 	}
+	const vector<int> original_input = input_vector;
 	cout << "-----------------" << endl;
 	if(comparison_type == "greater")
 	{
@@ -183,6 +478,30 @@ int main(int argc, char **argv) {
 		cout << endl;
 		cout << "----------------" << endl;
 		cout << endl;
+
+		PartitionComparison(original_input, greater<int>{});
+
+		cout << endl;
+		cout << "----------------" << endl;
+		cout << endl;
+
+		Selection(original_input, greater<int>{});
+
+		cout << endl;
+		cout << "----------------" << endl;
+		cout << endl;
+
+		ParallelQuickSortScaling(original_input, greater<int>{});
+
+		cout << endl;
+		cout << "----------------" << endl;
+		cout << endl;
+
+		NetworkLeafTypes(original_input, greater<int>{});
+
+		cout << endl;
+		cout << "----------------" << endl;
+		cout << endl;
 	}
 	else if(comparison_type == "less")
 	{
@@ -206,6 +525,30 @@ int main(int argc, char **argv) {
 		cout << endl;
 		cout << "----------------" << endl;
 		cout << endl;
+
+		PartitionComparison(original_input, less<int>{});
+
+		cout << endl;
+		cout << "----------------" << endl;
+		cout << endl;
+
+		Selection(original_input, less<int>{});
+
+		cout << endl;
+		cout << "----------------" << endl;
+		cout << endl;
+
+		ParallelQuickSortScaling(original_input, less<int>{});
+
+		cout << endl;
+		cout << "----------------" << endl;
+		cout << endl;
+
+		NetworkLeafTypes(original_input, less<int>{});
+
+		cout << endl;
+		cout << "----------------" << endl;
+		cout << endl;
 	}
  
 	return 0;
@@ -8,18 +8,86 @@
 		comparison_type can be "less" or "greater"
 	
 	This function will test three type of sorting: heapsort, quicksort, and mergesort
+	and compares them with 4-ary and 8-ary heapsort, bottom-up mergesort, TimSort
+	and radix sort. Every method sorts the same input.
+	The three-way quicksort (SORT) also sorts the input reduced to 16 keys.
+	Two parallel columns are sorted by the input with argsort and applyPermutation,
+	and the argsorts are checked to reject more items than their indexes hold.
+	Records of 16 to 512 bytes are sorted directly and indirectly, printing the
+	bytes each sort moves.
+	It also sorts the input by decimal string with a comparator and with a
+	key projection (keys extracted once per item), sorts the input as URLs
+	with a long common prefix with the string engines (multikey quicksort,
+	LCP merge sort) and the comparison sorts, and sorts copies held in a
+	raw buffer (through a span) and in a deque (through iterators), and
+	merges sorted shards of the input with the k-way merge, and keeps the
+	first 1000 items of the input with the streaming top-K accumulator.
+	It sorts the input in groups of 4, 8, 16 and 32 items (std::array) with
+	compile-time sorting networks and with insertion sort.
+	dispatchSort and dispatchStableSort, which choose an engine from the item
+	type and a scan of the input, sort the input and copies of it sorted,
+	reversed and in 8 runs, printing the engine each chose, and a tuning
+	profile with out-of-range cutoffs is checked to be ignored.
 	After each sort, it will print if the sorting is correct, and it will also prints
-	how long it took for each method to sort array
+	how long it took for each method to sort array, and the comparisons, moves,
+	swaps, recursion depth and partition balance of the comparison sorts
+	(counted by a separate instrumented sort of the same input), and, where
+	Linux hardware counters are available, the cycles, instructions, branch
+	misses, L1D/LLC/dTLB misses per element and the IPC of each timed sort
+	Finally it sorts the original input with the parallel mergesort using
+	1, 2, 4, ... threads (up to the number of cores) and prints the speedup.
 */
 #include "Sort.h"
+#include "ParallelSort.h"
+#include "PerfCounters.h"
+#include <array>
+#include <climits>
 #include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
 #include <iostream>
 #include <fstream>
 #include <functional>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <stdexcept>
 #include <string>
 #include <vector>
 using namespace std;
 
+namespace {
+// Bytes copied or moved by Record since it was last reset.
+long long moved_bytes = 0;
+
+// A record of Bytes bytes sorted by its key, which counts the bytes it moves.
+template <int Bytes, bool Indirect>
+struct Record {
+	int key;
+	char payload[Bytes - sizeof(int)];
+
+	Record() = default;
+	Record(const Record &other) noexcept {
+		memcpy(this, &other, Bytes);
+		moved_bytes += Bytes;
+	}
+	Record &operator=(const Record &other) noexcept {
+		memcpy(this, &other, Bytes);
+		moved_bytes += Bytes;
+		return *this;
+	}
+};
+}  // namespace
+
+// Sorts Record<Bytes, true> indirectly and Record<Bytes, false> directly, whatever their size.
+template <int Bytes, bool Indirect>
+struct IndirectSort<Record<Bytes, Indirect>> {
+	static const bool quicksort = Indirect;
+	static const bool mergeSort = Indirect;
+};
+
 namespace {
 // Test function that shows how you can time a piece of code.
 // Just times a simple loop.
@@ -62,34 +130,97 @@ bool VerifyOrder(const vector<Comparable> &input, Comparator compare) {
 	return true;
 }
 
+/**
+ * Sorts a copy of @a made of Tracked items with @sort and @compare instrumented
+ * (not timed: the counting slows the sort down)
+ * The counts describe the scalar path: Tracked items have no sorting network,
+ * so the quicksorts stop at INSERTION_SORT_CUTOFF and finish with insertion
+ * sort, where the timed sort of int stops at up to 32 items and finishes with
+ * the SIMD network.
+ * @return the comparisons, moves, swaps, recursion depth and partition balance
+ */
+template <typename Comparable, typename Comparator, typename Sorter>
+SortStats CountOperations(const vector<Comparable> &a, Comparator compare, Sorter sort) {
+	vector<Tracked<Comparable>> items(a.begin(), a.end());
+	SortStats stats;
+	TrackMoves track_moves(stats);
+	sort(items, instrument(compare, stats));
+	return stats;
+}
+
+// Prints the counts of @stats (the partition balance only if there were partitions)
+void PrintCounts(const SortStats &stats) {
+	cout << "Scalar path, comparisons: " << stats.comparisons << " Moves: " << stats.moves
+		<< " Swaps: " << stats.swaps << " Max depth: " << stats.maxDepth << endl;
+	long long partitions = 0;
+	for (long long count : stats.partitionBalance)
+		partitions += count;
+	if (partitions == 0)
+		return;
+	cout << "Partition balance (smaller side 0-10%, 10-20%, 20-30%, 30-40%, 40-50%):";
+	for (long long count : stats.partitionBalance)
+		cout << " " << count;
+	cout << endl;
+}
+
+// Hardware counters of this thread, opened once (PerfCounters.h)
+PerfCounters &Counters() {
+	static PerfCounters counters;
+	return counters;
+}
+
+// Prints @counts per element of the @n sorted items, and the IPC
+// (nothing if no counter is available: timing only)
+void PrintPerfCounts(const PerfCounts &counts, size_t n) {
+	if (!counts.any() || n == 0)
+		return;
+	cout << "Per element:";
+	for (int event = 0; event < PERF_EVENT_COUNT; ++event)
+		if (counts.counted[event])
+			cout << " " << perfEventName(event) << ": " << (double) counts.value[event] / n;
+	if (counts.ipc() > 0)
+		cout << " IPC: " << counts.ipc();
+	cout << endl;
+}
+
 
 // Signature for quicksort (heapsort / mergesort similar signatures)*template <typename Comparable, typename Comparator>
 template <typename Comparable, typename Comparator>
 void QuickSort(vector<Comparable> &a, Comparator compare) {
+	const SortStats stats = CountOperations(a, compare, [](auto &items, auto counted) { quicksort(items, counted); });
 	cout << "Run time: ";
+	Counters().start();
 	const auto begin = chrono::high_resolution_clock::now();
 	// Time this piece of code.
 	quicksort(a, compare);
 	// End of piece of code to time.
 	const auto end = chrono::high_resolution_clock::now();    
+	const PerfCounts counts = Counters().stop();
 	cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() << "ns";
 	cout << " or ";
 	cout << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms" << endl;
+	PrintCounts(stats);
+	PrintPerfCounts(counts, a.size());
  
 }
 
 // Signature for quicksort (heapsort / mergesort similar signatures)
 template <typename Comparable, typename Comparator>
 void MergeSort(vector<Comparable> &a, Comparator compare) {
+	const SortStats stats = CountOperations(a, compare, [](auto &items, auto counted) { mergeSort(items, counted); });
 	cout << "Run time: ";
+	Counters().start();
 	const auto begin = chrono::high_resolution_clock::now();
 	// Time this piece of code.
 	mergeSort(a, compare);
 	// End of piece of code to time.
 	const auto end = chrono::high_resolution_clock::now();    
+	const PerfCounts counts = Counters().stop();
 	cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() << "ns";
 	cout << " or ";
 	cout << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms" << endl;
+	PrintCounts(stats);
+	PrintPerfCounts(counts, a.size());
 
 }
 
@@ -98,18 +229,560 @@ void MergeSort(vector<Comparable> &a, Comparator compare) {
 // Signature for quicksort (heapsort / mergesort similar signatures)
 template <typename Comparable, typename Comparator>
 void HeapSort(vector<Comparable> &a, Comparator compare) {
+	const SortStats stats = CountOperations(a, compare, [](auto &items, auto counted) { heapsort(items, counted); });
 	cout << "Run time: ";
+	Counters().start();
 	const auto begin = chrono::high_resolution_clock::now();
 	// Time this piece of code.
 	heapsort(a, compare);
 	// End of piece of code to time.
 	const auto end = chrono::high_resolution_clock::now();    
+	const PerfCounts counts = Counters().stop();
 	cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() << "ns";
 	cout << " or ";
 	cout << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms" << endl;
+	PrintCounts(stats);
+	PrintPerfCounts(counts, a.size());
  
 }
 
+// Signature for heapsort with a heap of arity @Arity (4 or 8)
+template <int Arity, typename Comparable, typename Comparator>
+void DAryHeapSort(vector<Comparable> &a, Comparator compare) {
+	const SortStats stats = CountOperations(a, compare, [](auto &items, auto counted) { dAryHeapsort<Arity>(items, counted); });
+	cout << "Run time: ";
+	Counters().start();
+	const auto begin = chrono::high_resolution_clock::now();
+	// Time this piece of code.
+	dAryHeapsort<Arity>(a, compare);
+	// End of piece of code to time.
+	const auto end = chrono::high_resolution_clock::now();    
+	const PerfCounts counts = Counters().stop();
+	cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() << "ns";
+	cout << " or ";
+	cout << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms" << endl;
+	PrintCounts(stats);
+	PrintPerfCounts(counts, a.size());
+
+}
+
+/**
+ * Sorts copies of @input with dAryHeapsort<Arity> through spans starting
+ * 0 to 15 items past a cache line, so the heap layout meets every skew.
+ * Prints 1 for verified if every copy is in order.
+ */
+template <int Arity, typename Comparable, typename Comparator>
+void DAryHeapSortSkewed(const vector<Comparable> &input, Comparator compare) {
+	const size_t n = min<size_t>(input.size(), 10000);
+	const size_t offsets = 16;
+	vector<Comparable> buffer(n + offsets + 64 / sizeof(Comparable));
+	Comparable *line = buffer.data();
+	while (reinterpret_cast<uintptr_t>(line) % 64 != 0)
+		++line;
+	bool verified = true;
+	for (size_t offset = 0; offset < offsets; ++offset) {
+		const span<Comparable> a(line + offset, n);
+		copy_n(input.begin(), n, a.begin());
+		dAryHeapsort<Arity>(a, compare);
+		verified = verified && is_sorted(a.begin(), a.end(), compare);
+	}
+	cout << "Skewed arrays (0 to 15 items past a cache line): Verified: " << verified << endl;
+}
+
+// Signature for bottom-up mergesort (no copy back after each merge)
+template <typename Comparable, typename Comparator>
+void MergeSortBottomUp(vector<Comparable> &a, Comparator compare) {
+	const SortStats stats = CountOperations(a, compare, [](auto &items, auto counted) { mergeSortBottomUp(items, counted); });
+	cout << "Run time: ";
+	Counters().start();
+	const auto begin = chrono::high_resolution_clock::now();
+	// Time this piece of code.
+	mergeSortBottomUp(a, compare);
+	// End of piece of code to time.
+	const auto end = chrono::high_resolution_clock::now();    
+	const PerfCounts counts = Counters().stop();
+	cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() << "ns";
+	cout << " or ";
+	cout << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms" << endl;
+	PrintCounts(stats);
+	PrintPerfCounts(counts, a.size());
+
+}
+
+// Signature for TimSort (adaptive natural mergesort)
+template <typename Comparable, typename Comparator>
+void TimSortTest(vector<Comparable> &a, Comparator compare) {
+	const SortStats stats = CountOperations(a, compare, [](auto &items, auto counted) { timSort(items, counted); });
+	cout << "Run time: ";
+	Counters().start();
+	const auto begin = chrono::high_resolution_clock::now();
+	// Time this piece of code.
+	timSort(a, compare);
+	// End of piece of code to time.
+	const auto end = chrono::high_resolution_clock::now();    
+	const PerfCounts counts = Counters().stop();
+	cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() << "ns";
+	cout << " or ";
+	cout << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms" << endl;
+	PrintCounts(stats);
+	PrintPerfCounts(counts, a.size());
+
+}
+
+// Signature for radix sort (integral keys, less or greater only)
+template <typename Comparable, typename Comparator>
+void RadixSort(vector<Comparable> &a, Comparator compare) {
+	cout << "Run time: ";
+	Counters().start();
+	const auto begin = chrono::high_resolution_clock::now();
+	// Time this piece of code.
+	radixSort(a, compare);
+	// End of piece of code to time.
+	const auto end = chrono::high_resolution_clock::now();    
+	const PerfCounts counts = Counters().stop();
+	cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() << "ns";
+	cout << " or ";
+	cout << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms" << endl;
+	PrintPerfCounts(counts, a.size());
+ 
+}
+
+// Projection used by ProjectedMergeSort: the decimal string of an item
+struct DecimalString {
+	string operator()(int x) const { return to_string(x); }
+};
+
+// Comparator that projects both items on every comparison
+template <typename KeyComparator>
+struct CompareDecimalStrings {
+	KeyComparator compare_keys;
+	bool operator()(int x, int y) const { return compare_keys(to_string(x), to_string(y)); }
+};
+
+/**
+ * Sorts a copy of @input and a copy reduced to 16 distinct keys with the
+ * in-place three-way quicksort (SORT).
+ * Prints run time, verified order and the operation counts for both.
+ */
+template <typename Comparator>
+void ThreeWayQuickSort(const vector<int> &input, Comparator compare) {
+	for (int few_keys = 0; few_keys < 2; ++few_keys) {
+		vector<int> a = input;
+		if (few_keys)
+			for (int &x : a)
+				x %= 16;
+		const SortStats stats = CountOperations(a, compare, [](auto &items, auto counted) { SORT(items, counted); });
+		Counters().start();
+		const auto begin = chrono::high_resolution_clock::now();
+		// Time this piece of code.
+		SORT(a, compare);
+		// End of piece of code to time.
+		const auto end = chrono::high_resolution_clock::now();
+		const PerfCounts counts = Counters().stop();
+		cout << (few_keys ? "16 distinct keys:" : "Input:") << " Run time: ";
+		cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() << "ns";
+		cout << " or ";
+		cout << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms";
+		cout << " Verified: " << VerifyOrder(a, compare) << endl;
+		PrintCounts(stats);
+		PrintPerfCounts(counts, a.size());
+	}
+}
+
+/**
+ * Sorts two parallel columns (the input and the original position of each
+ * item) by the first one: argsort with quicksort, mergesort and radix sort,
+ * then applyPermutation on both columns.
+ * Prints run time, verified order and whether the rows stayed together.
+ */
+template <typename Comparator>
+void ArgsortColumns(const vector<int> &input, Comparator compare) {
+	const char *names[] = {"Argsort quick sort:", "Argsort merge sort:", "Argsort radix sort:"};
+	for (int method = 0; method < 3; ++method) {
+		vector<int> keys = input;
+		vector<int> positions(input.size());
+		for (size_t i = 0; i < positions.size(); ++i)
+			positions[i] = i;
+		const auto begin = chrono::high_resolution_clock::now();
+		// Time this piece of code.
+		const vector<uint32_t> perm = method == 0 ? argQuicksort(keys, compare)
+		                            : method == 1 ? argMergeSort(keys, compare)
+		                                          : argRadixSort(keys, compare);
+		applyPermutation(perm, keys, positions);
+		// End of piece of code to time.
+		const auto end = chrono::high_resolution_clock::now();
+		bool rows_match = true;
+		for (size_t i = 0; i < keys.size(); ++i)
+			rows_match = rows_match && input[positions[i]] == keys[i];
+		cout << names[method] << " Run time: ";
+		cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() << "ns";
+		cout << " or ";
+		cout << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms";
+		cout << " Verified: " << VerifyOrder(keys, compare) << " Rows match: " << rows_match << endl;
+	}
+}
+
+/**
+ * Checks that argsorts reject what their indexes cannot hold: more than
+ * INT_MAX items for argQuicksort and argMergeSort (a range of 2^31
+ * counters, never read) and more items than the index type can number.
+ * Prints 1 for verified if each one throws length_error.
+ */
+template <typename Comparator>
+void ArgsortLimits(const vector<int> &input, Comparator compare) {
+	const auto huge = views::iota(size_t(0), (size_t) INT_MAX + 1);
+	const vector<function<void()>> too_large = {
+		[&] { argQuicksort(huge.begin(), huge.end(), less<size_t>{}); },
+		[&] { argMergeSort(huge.begin(), huge.end(), less<size_t>{}); },
+		[&] { argQuicksort<uint8_t>(input.begin(), input.begin() + min<size_t>(input.size(), 257), compare); },
+		[&] { argRadixSort<uint8_t>(input.begin(), input.begin() + min<size_t>(input.size(), 257), compare); },
+	};
+	int rejected = 0;
+	for (const function<void()> &argsort : too_large) {
+		try {
+			argsort();
+		} catch (const length_error &) {
+			++rejected;
+		}
+	}
+	const int expected = input.size() >= 257 ? 4 : 2;
+	cout << "Argsort limits: Verified: " << (rejected == expected) << endl;
+}
+
+/**
+ * Sorts Records of Bytes bytes made from the keys of @input with quicksort
+ * and mergesort, directly (moving the records) and indirectly (sorting
+ * indexes, then moving each record once).
+ * Prints run time, bytes moved and verified order for each.
+ */
+template <int Bytes, bool Indirect, typename Comparator>
+void SortRecords(const vector<int> &input, Comparator compare) {
+	auto compare_keys = [compare](const Record<Bytes, Indirect> &x, const Record<Bytes, Indirect> &y) {
+		return compare(x.key, y.key);
+	};
+	for (int merge = 0; merge < 2; ++merge) {
+		vector<Record<Bytes, Indirect>> a(input.size());
+		for (size_t i = 0; i < input.size(); ++i)
+			a[i].key = input[i];
+		moved_bytes = 0;
+		const auto begin = chrono::high_resolution_clock::now();
+		// Time this piece of code.
+		if (merge)
+			mergeSort(a, compare_keys);
+		else
+			quicksort(a, compare_keys);
+		// End of piece of code to time.
+		const auto end = chrono::high_resolution_clock::now();
+		cout << Bytes << "B " << (merge ? "merge" : "quick") << " sort, " << (Indirect ? "indirect:" : "direct:  ");
+		cout << " Run time: " << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms";
+		cout << " Moved: " << moved_bytes / 1024 << "KB";
+		cout << " Verified: " << VerifyOrder(a, compare_keys) << endl;
+	}
+}
+
+/**
+ * Sorts the first 100000 items of @input as records of 16 to 512 bytes,
+ * directly and indirectly, to show where the indirect sort starts to pay off
+ * (quicksort and mergeSort switch to it by themselves above
+ * INDIRECT_QUICKSORT_MIN_SIZE and INDIRECT_MERGE_SORT_MIN_SIZE bytes).
+ */
+template <typename Comparator>
+void DirectVsIndirect(const vector<int> &input, Comparator compare) {
+	const vector<int> keys(input.begin(), input.begin() + min<size_t>(input.size(), 100000));
+	SortRecords<16, false>(keys, compare);
+	SortRecords<16, true>(keys, compare);
+	SortRecords<64, false>(keys, compare);
+	SortRecords<64, true>(keys, compare);
+	SortRecords<256, false>(keys, compare);
+	SortRecords<256, true>(keys, compare);
+	SortRecords<512, false>(keys, compare);
+	SortRecords<512, true>(keys, compare);
+}
+
+/**
+ * Sorts copies of @input by their decimal strings (e.g. 10 before 9 for less),
+ * once with a comparator that converts both items on every comparison and
+ * once with the projection overload of mergeSort that converts each item once.
+ * Prints run time and verified order for both.
+ */
+template <typename KeyComparator>
+void ProjectedMergeSort(const vector<int> &input, KeyComparator compare_keys) {
+	const CompareDecimalStrings<KeyComparator> compare{compare_keys};
+	for (int projected = 0; projected < 2; ++projected) {
+		vector<int> a = input;
+		const auto begin = chrono::high_resolution_clock::now();
+		// Time this piece of code.
+		if (projected)
+			mergeSort(a, compare_keys, DecimalString{});
+		else
+			mergeSort(a, compare);
+		// End of piece of code to time.
+		const auto end = chrono::high_resolution_clock::now();
+		cout << (projected ? "Projection, keys cached:" : "Comparator, keys per compare:") << " Run time: ";
+		cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() << "ns";
+		cout << " or ";
+		cout << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms";
+		cout << " Verified: " << VerifyOrder(a, compare) << endl;
+	}
+}
+
+/**
+ * Sorts the input as URLs sharing a 34-character prefix with quicksort,
+ * mergeSort, stringSort (multikey quicksort) and stableStringSort (LCP
+ * merge sort).
+ * Prints run time and verified order for each.
+ */
+template <typename Comparator>
+void SortUrls(const vector<int> &input, Comparator compare) {
+	vector<string> urls;
+	for (int item : input)
+		urls.push_back("https://example.com/catalog/items/" + to_string(item));
+	const vector<pair<string, function<void(vector<string> &)>>> sorters = {
+		{"quicksort", [compare](vector<string> &a) { quicksort(a, compare); }},
+		{"mergeSort", [compare](vector<string> &a) { mergeSort(a, compare); }},
+		{"stringSort", [compare](vector<string> &a) { stringSort(a, compare); }},
+		{"stableStringSort", [compare](vector<string> &a) { stableStringSort(a, compare); }},
+	};
+	for (const auto &[name, sorter] : sorters) {
+		vector<string> a = urls;
+		const auto begin = chrono::high_resolution_clock::now();
+		// Time this piece of code.
+		sorter(a);
+		// End of piece of code to time.
+		const auto end = chrono::high_resolution_clock::now();
+		cout << name << ": Run time: ";
+		cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() << "ns";
+		cout << " or ";
+		cout << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms";
+		cout << " Verified: " << VerifyOrder(a, compare) << endl;
+	}
+}
+
+/**
+ * Sorts copies of @input that are not in a vector, without copying them:
+ * a raw heap buffer through a span (quicksort) and a deque through its
+ * iterators (mergesort).
+ * Prints run time and verified order for both.
+ */
+template <typename Comparable, typename Comparator>
+void ExternalBufferSorts(const vector<Comparable> &input, Comparator compare) {
+	unique_ptr<Comparable[]> buffer(new Comparable[input.size()]);
+	copy(input.begin(), input.end(), buffer.get());
+	span<Comparable> view(buffer.get(), input.size());
+	deque<Comparable> items(input.begin(), input.end());
+
+	for (int container = 0; container < 2; ++container) {
+		const auto begin = chrono::high_resolution_clock::now();
+		// Time this piece of code.
+		if (container == 0)
+			quicksort(view, compare);
+		else
+			mergeSort(items.begin(), items.end(), compare);
+		// End of piece of code to time.
+		const auto end = chrono::high_resolution_clock::now();
+		cout << (container == 0 ? "Quick sort, raw buffer (span):" : "Merge sort, deque (iterators):") << " Run time: ";
+		cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() << "ns";
+		cout << " or ";
+		cout << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms";
+		cout << " Verified: " << (container == 0 ? is_sorted(view.begin(), view.end(), compare)
+		                                         : is_sorted(items.begin(), items.end(), compare)) << endl;
+	}
+}
+
+/**
+ * Sorts @input in consecutive groups of N items held in std::array, with
+ * staticNetworkSort (unrolled at compile time) and with insertionSort.
+ * Prints run time and whether every group is in order for both.
+ */
+template <size_t N, typename Comparator>
+void SortFixedGroups(const vector<int> &input, Comparator compare) {
+	vector<array<int, N>> groups(input.size() / N);
+	for (size_t g = 0; g < groups.size(); ++g)
+		copy_n(input.begin() + g * N, N, groups[g].begin());
+	for (int network = 1; network >= 0; --network) {
+		vector<array<int, N>> a = groups;
+		const auto begin = chrono::high_resolution_clock::now();
+		// Time this piece of code.
+		if (network)
+			for (array<int, N> &group : a)
+				staticNetworkSort(group, compare);
+		else
+			for (array<int, N> &group : a)
+				insertionSort(group.begin(), group.end(), compare);
+		// End of piece of code to time.
+		const auto end = chrono::high_resolution_clock::now();
+		bool verified = true;
+		for (const array<int, N> &group : a)
+			verified = verified && is_sorted(group.begin(), group.end(), compare);
+		cout << N << " items, " << (network ? "network:" : "insertion sort:") << " Run time: ";
+		cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() << "ns";
+		cout << " or ";
+		cout << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms";
+		cout << " Verified: " << verified << endl;
+	}
+}
+
+// staticNetworkSort also sorts in constant expressions
+constexpr bool NetworkSortsAtCompileTime() {
+	array<int, 5> a = {3, 1, 4, 1, 5};
+	staticNetworkSort(a);
+	double b[3] = {2.5, -1, 0};
+	staticNetworkSort(b, greater<double>{});
+	return a[0] == 1 && a[1] == 1 && a[4] == 5 && b[0] == 2.5 && b[2] == -1;
+}
+static_assert(NetworkSortsAtCompileTime());
+
+/**
+ * Sorts @input, and copies of it sorted, reversed and cut into 8 sorted
+ * runs, with dispatchSort and dispatchStableSort.
+ * Prints the engine each one chose, run time and verified order.
+ */
+template <typename Comparable, typename Comparator>
+void DispatchingSort(const vector<Comparable> &input, Comparator compare) {
+	vector<Comparable> sorted = input;
+	heapsort(sorted, compare);
+	vector<Comparable> reversed(sorted.rbegin(), sorted.rend());
+	vector<Comparable> runs = input;
+	for (size_t run = 0; run < 8; ++run)
+		heapsort(span<Comparable>(runs).subspan(run * runs.size() / 8, (run + 1) * runs.size() / 8 - run * runs.size() / 8),
+		         compare);
+	const vector<pair<string, const vector<Comparable> *>> inputs = {
+		{"input", &input}, {"sorted", &sorted}, {"reversed", &reversed}, {"8 runs", &runs}};
+	for (const auto &[name, items] : inputs)
+		for (int stable = 0; stable <= 1; ++stable) {
+			vector<Comparable> a = *items;
+			const auto begin = chrono::high_resolution_clock::now();
+			// Time this piece of code.
+			const SortEngine engine = stable ? dispatchStableSort(a, compare) : dispatchSort(a, compare);
+			// End of piece of code to time.
+			const auto end = chrono::high_resolution_clock::now();
+			cout << (stable ? "dispatchStableSort, " : "dispatchSort, ") << name << ": " << sortEngineName(engine) << " Run time: ";
+			cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() << "ns";
+			cout << " or ";
+			cout << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms";
+			cout << " Verified: " << (a == sorted) << endl;
+		}
+}
+
+/**
+ * Loads a tuning profile whose cutoffs are 0, 20 and TUNING_MAX_CUTOFF + 1
+ * (in buckets 4, 5 and 6) into a profile of its own.
+ * Prints whether only the cutoff of 20 was kept (bucket 6 then resolves to
+ * bucket 5, like an unmeasured bucket).
+ */
+void TuningProfileLimits() {
+	const string path = "tuning_limits.profile";
+	{
+		ofstream out(path);
+		out << "int32 less 4 quicksort 0\n";
+		out << "int32 less 5 quicksort 20\n";
+		out << "int32 less 6 quicksort " << TUNING_MAX_CUTOFF + 1 << "\n";
+	}
+	SortTuningProfile profile;
+	const bool loaded = profile.load(path);
+	remove(path.c_str());
+	const TuningEntry &entry = profile.find(TUNED_INT32, false, 1 << 6);
+	cout << "Tuning profile, out-of-range cutoffs ignored: Verified: "
+	     << (loaded && entry.tuned() && entry.cutoff == 20 && profile.find(TUNED_INT32, false, 1 << 4).cutoff == 20)
+	     << endl;
+}
+
+/**
+ * Keeps the first 1000 items of @input (for @compare) with a TopK
+ * accumulator fed in batches of 4096 items, as a stream would be.
+ * Prints run time and whether the drained items match a full sort.
+ */
+template <typename Comparable, typename Comparator>
+void TopKStream(const vector<Comparable> &input, Comparator compare) {
+	const int k = 1000;
+	const size_t batch = 4096;
+	TopK<Comparable, Comparator> top(k, compare);
+	const auto begin = chrono::high_resolution_clock::now();
+	// Time this piece of code.
+	for (size_t i = 0; i < input.size(); i += batch)
+		top.push(input.begin() + i, input.begin() + min(input.size(), i + batch));
+	const vector<Comparable> a = top.drain();
+	// End of piece of code to time.
+	const auto end = chrono::high_resolution_clock::now();
+	vector<Comparable> sorted = input;
+	heapsort(sorted, compare);
+	sorted.resize(min<size_t>(k, sorted.size()));
+	cout << "Top " << a.size() << " Run time: ";
+	cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() << "ns";
+	cout << " or ";
+	cout << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms";
+	cout << " Verified: " << (a == sorted) << endl;
+}
+
+/**
+ * Splits @input into 64 shards (fewer for small inputs), sorts each one and
+ * merges them with kWayMerge.
+ * Prints run time, comparisons per item (about log2 of the shard count)
+ * and verified order.
+ */
+template <typename Comparable, typename Comparator>
+void KWayMergeShards(const vector<Comparable> &input, Comparator compare) {
+	const size_t num_shards = min<size_t>(64, input.size());
+	vector<vector<Comparable>> shards(num_shards);
+	for (size_t i = 0; i < input.size(); ++i)
+		shards[i % num_shards].push_back(input[i]);
+	for (vector<Comparable> &shard : shards)
+		quicksort(shard, compare);
+
+	long long comparisons = 0;
+	auto counting_compare = [&comparisons, compare](const Comparable &x, const Comparable &y) {
+		++comparisons;
+		return compare(x, y);
+	};
+	vector<Comparable> a(input.size());
+	const auto begin = chrono::high_resolution_clock::now();
+	// Time this piece of code.
+	kWayMerge(shards, a.begin(), counting_compare);
+	// End of piece of code to time.
+	const auto end = chrono::high_resolution_clock::now();
+	cout << "Shards: " << num_shards << " Run time: ";
+	cout << chrono::duration_cast<chrono::nanoseconds>(end - begin).count() << "ns";
+	cout << " or ";
+	cout << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms";
+	cout << " Comparisons per item: " << (double) comparisons / input.size();
+	cout << " Verified: " << VerifyOrder(a, compare) << endl;
+}
+
+/**
+ * Sorts a copy of @input with parallelMergeSort for 1, 2, 4, ... threads
+ * up to the number of hardware threads.
+ * Prints run time, speedup over one thread and verified order for each count.
+ */
+template <typename Comparable, typename Comparator>
+void ParallelMergeSortScaling(const vector<Comparable> &input, Comparator compare) {
+	cout << "[ Parallel Merge Sort ]" << endl;
+
+	const int max_threads = defaultThreadCount();
+	vector<int> thread_counts;
+	for (int t = 1; t < max_threads; t *= 2)
+		thread_counts.push_back(t);
+	thread_counts.push_back(max_threads);
+
+	long long single_thread_ns = 0;
+	for (int threads : thread_counts) {
+		vector<Comparable> a = input;
+		const auto begin = chrono::high_resolution_clock::now();
+		// Time this piece of code.
+		parallelMergeSort(a, compare, threads);
+		// End of piece of code to time.
+		const auto end = chrono::high_resolution_clock::now();
+		const long long ns = chrono::duration_cast<chrono::nanoseconds>(end - begin).count();
+		if (threads == 1)
+			single_thread_ns = ns;
+
+		cout << "Threads: " << threads << " Run time: " << ns << "ns";
+		cout << " or ";
+		cout << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms";
+		cout << " Speedup: " << (ns > 0 ? (double) single_thread_ns / ns : 0.0);
+		cout << " Verified: " << VerifyOrder(a, compare) << endl;
+	}
+}
+
 }  // namespace
 int main(int argc, char **argv) {
 	if (argc != 4) {
@@ -135,6 +808,8 @@ int main(int argc, char **argv) {
   
 	cout << "Running sorting algorithms: " << input_type << " " << input_size << " numbers " 
        << comparison_type << endl;
+	if (!Counters().available())
+		cout << "Hardware counters unavailable: timing only" << endl;
 	vector<int> input_vector;
 	if (input_type == "random") {
 		input_vector = GenerateRandomVector(input_size);
@@ -143,6 +818,7 @@ int main(int argc, char **argv) {
 		for(int i = 0; i < input_size; i++)
 			input_vector.push_back(i);
 	}
+	const vector<int> original_input = input_vector;
 	cout << "-----------------" << endl;
 	if(comparison_type == "greater")
 	{
@@ -154,6 +830,27 @@ int main(int argc, char **argv) {
 		cout << "-----------------" << endl; 
 		cout << endl;
 
+		input_vector = original_input;
+		cout << "[ 4-ary Heap Sort ]" << endl;
+		DAryHeapSort<4>(input_vector, greater<int>{});
+		cout << "Verified: " << VerifyOrder(input_vector, greater<int>{}) << endl;
+		DAryHeapSortSkewed<4>(original_input, greater<int>{});
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		input_vector = original_input;
+		cout << "[ 8-ary Heap Sort ]" << endl;
+		DAryHeapSort<8>(input_vector, greater<int>{});
+		cout << "Verified: " << VerifyOrder(input_vector, greater<int>{}) << endl;
+		DAryHeapSortSkewed<8>(original_input, greater<int>{});
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		input_vector = original_input;
 		cout << "[ Merge Sort ]" << endl;
 		MergeSort(input_vector, greater<int>{});
 		cout << "Verified: " << VerifyOrder(input_vector, greater<int>{}) << endl;
@@ -162,6 +859,25 @@ int main(int argc, char **argv) {
 		cout << "-----------------" << endl; 
 		cout << endl;
 
+		input_vector = original_input;
+		cout << "[ Bottom-up Merge Sort ]" << endl;
+		MergeSortBottomUp(input_vector, greater<int>{});
+		cout << "Verified: " << VerifyOrder(input_vector, greater<int>{}) << endl;
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		input_vector = original_input;
+		cout << "[ TimSort ]" << endl;
+		TimSortTest(input_vector, greater<int>{});
+		cout << "Verified: " << VerifyOrder(input_vector, greater<int>{}) << endl;
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		input_vector = original_input;
 		cout << "[ Quick Sort ]" << endl;
 		QuickSort(input_vector, greater<int>{});
 		cout << "Verified: " << VerifyOrder(input_vector, greater<int>{}) << endl;
@@ -169,6 +885,96 @@ int main(int argc, char **argv) {
 		cout << endl;
 		cout << "-----------------" << endl; 
 		cout << endl;
+
+		input_vector = original_input;
+		cout << "[ Radix Sort ]" << endl;
+		RadixSort(input_vector, greater<int>{});
+		cout << "Verified: " << VerifyOrder(input_vector, greater<int>{}) << endl;
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		cout << "[ Three-way Quick Sort ]" << endl;
+		ThreeWayQuickSort(original_input, greater<int>{});
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		cout << "[ Argsort of two columns ]" << endl;
+		ArgsortColumns(original_input, greater<int>{});
+		ArgsortLimits(original_input, greater<int>{});
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		cout << "[ Direct vs indirect sort of records ]" << endl;
+		DirectVsIndirect(original_input, greater<int>{});
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		cout << "[ Merge Sort by decimal string ]" << endl;
+		ProjectedMergeSort(original_input, greater<string>{});
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		cout << "[ String sort of URLs ]" << endl;
+		SortUrls(original_input, greater<string>{});
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		cout << "[ External buffers ]" << endl;
+		ExternalBufferSorts(original_input, greater<int>{});
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		cout << "[ k-way Merge of sorted shards ]" << endl;
+		KWayMergeShards(original_input, greater<int>{});
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		cout << "[ Streaming top 1000 ]" << endl;
+		TopKStream(original_input, greater<int>{});
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		cout << "[ Fixed-size groups ]" << endl;
+		SortFixedGroups<4>(original_input, greater<int>{});
+		SortFixedGroups<8>(original_input, greater<int>{});
+		SortFixedGroups<16>(original_input, greater<int>{});
+		SortFixedGroups<32>(original_input, greater<int>{});
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		cout << "[ Dispatching sort ]" << endl;
+		DispatchingSort(original_input, greater<int>{});
+		TuningProfileLimits();
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		ParallelMergeSortScaling(original_input, greater<int>{});
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
 	}
 	else if(comparison_type == "less")
 	{
@@ -181,6 +987,27 @@ int main(int argc, char **argv) {
 		cout << "-----------------" << endl; 
 		cout << endl;
 
+		input_vector = original_input;
+		cout << "[ 4-ary Heap Sort ]" << endl;
+		DAryHeapSort<4>(input_vector, less<int>{});
+		cout << "Verified: " << VerifyOrder(input_vector, less<int>{}) << endl;
+		DAryHeapSortSkewed<4>(original_input, less<int>{});
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		input_vector = original_input;
+		cout << "[ 8-ary Heap Sort ]" << endl;
+		DAryHeapSort<8>(input_vector, less<int>{});
+		cout << "Verified: " << VerifyOrder(input_vector, less<int>{}) << endl;
+		DAryHeapSortSkewed<8>(original_input, less<int>{});
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		input_vector = original_input;
 		cout << "[ Merge Sort ]" <<endl;
 		MergeSort(input_vector, less<int>{});
 		cout << "Verified: " << VerifyOrder(input_vector, less<int>{}) << endl;
@@ -189,12 +1016,121 @@ int main(int argc, char **argv) {
 		cout << "-----------------" << endl; 
 		cout << endl;
 
+		input_vector = original_input;
+		cout << "[ Bottom-up Merge Sort ]" << endl;
+		MergeSortBottomUp(input_vector, less<int>{});
+		cout << "Verified: " << VerifyOrder(input_vector, less<int>{}) << endl;
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		input_vector = original_input;
+		cout << "[ TimSort ]" << endl;
+		TimSortTest(input_vector, less<int>{});
+		cout << "Verified: " << VerifyOrder(input_vector, less<int>{}) << endl;
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		input_vector = original_input;
 		cout << "[ Quick Sort ]" << endl;
 		QuickSort(input_vector, less<int>{});
 		cout << "Verified: " << VerifyOrder(input_vector, less<int>{}) << endl;
 
 		cout << endl;
 		cout << "-----------------" << endl; 
+		cout << endl;
+
+		input_vector = original_input;
+		cout << "[ Radix Sort ]" << endl;
+		RadixSort(input_vector, less<int>{});
+		cout << "Verified: " << VerifyOrder(input_vector, less<int>{}) << endl;
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		cout << "[ Three-way Quick Sort ]" << endl;
+		ThreeWayQuickSort(original_input, less<int>{});
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		cout << "[ Argsort of two columns ]" << endl;
+		ArgsortColumns(original_input, less<int>{});
+		ArgsortLimits(original_input, less<int>{});
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		cout << "[ Direct vs indirect sort of records ]" << endl;
+		DirectVsIndirect(original_input, less<int>{});
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		cout << "[ Merge Sort by decimal string ]" << endl;
+		ProjectedMergeSort(original_input, less<string>{});
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		cout << "[ String sort of URLs ]" << endl;
+		SortUrls(original_input, less<string>{});
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		cout << "[ External buffers ]" << endl;
+		ExternalBufferSorts(original_input, less<int>{});
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		cout << "[ k-way Merge of sorted shards ]" << endl;
+		KWayMergeShards(original_input, less<int>{});
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		cout << "[ Streaming top 1000 ]" << endl;
+		TopKStream(original_input, less<int>{});
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		cout << "[ Fixed-size groups ]" << endl;
+		SortFixedGroups<4>(original_input, less<int>{});
+		SortFixedGroups<8>(original_input, less<int>{});
+		SortFixedGroups<16>(original_input, less<int>{});
+		SortFixedGroups<32>(original_input, less<int>{});
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		cout << "[ Dispatching sort ]" << endl;
+		DispatchingSort(original_input, less<int>{});
+		TuningProfileLimits();
+
+		cout << endl;
+		cout << "-----------------" << endl;
+		cout << endl;
+
+		ParallelMergeSortScaling(original_input, less<int>{});
+
+		cout << endl;
+		cout << "-----------------" << endl;
 		cout << endl;	
 	}
 	return 0;
@@ -0,0 +1,235 @@
+// Calibration of the sorting routines for this host
+/*
+	To execute this program:
+		./tune_sorting	[--output sort_tuning.profile]	[--types int32,int64,double,string]
+			[--max_size 262144]	[--trials 5]	[--seed 1]
+		Every option is optional.
+
+	For every element type, order (less and greater) and size bucket (sizes
+	24, 96, 384, ... up to --max_size, one size per two powers of 2) it sorts
+	random inputs and measures:
+		1. quicksort with each candidate leaf cutoff (4 to 64, capped to 32 or 16
+		   where the leaves use a sorting network; the capped cutoff is saved),
+		2. quicksort, mergeSort, heapsort, SORT and timSort with the best cutoff.
+	The best cutoff and the fastest algorithm of each bucket are printed and
+	saved in the tuning profile (SortTuning.h). Programs sorting in the
+	directory of the profile, or with SORT_TUNING_PROFILE set to its path, use
+	the cutoff in quicksort, quicksortMiddle, quicksortFirst and SORT and the
+	algorithm in tunedSort.
+	Each time is the median of --trials sorts of a batch of copies of the input
+	(at least 65536 items), so small sizes are measured as long as large ones.
+*/
+#include "Sort.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+namespace {
+
+const vector<string> ALL_TYPES = {"int32", "int64", "double", "string"};
+
+// Leaf cutoffs tried; those the leaf caps to the same cutoff are measured once.
+const vector<int> CUTOFFS = {4, 8, 12, 16, 24, 32, 48, 64};
+
+// Items sorted per measurement at least (small inputs are sorted in batches).
+const size_t BATCH_ITEMS = 1 << 16;
+
+struct Options {
+	string output = "sort_tuning.profile";
+	vector<string> types = ALL_TYPES;
+	long long max_size = 1 << 18;
+	int trials = 5;
+	unsigned long long seed = 1;
+};
+
+// Converts a random key to an element.
+template <typename T>
+T MakeItem(unsigned long long key) {
+	return T(key >> 33);
+}
+
+template <>
+string MakeItem<string>(unsigned long long key) {
+	char text[32];
+	snprintf(text, sizeof(text), "key-%010llu", key >> 33);
+	return text;
+}
+
+/**
+ * Sorts a batch of copies of @input with @sort @trials times
+ * @return the median time of one sort in ns
+ */
+template <typename T>
+double MedianTime(const vector<T> &input, const function<void(vector<T> &)> &sort, int trials) {
+	const size_t batch = max<size_t>(1, BATCH_ITEMS / input.size());
+	vector<double> times;
+	for (int trial = -1; trial < trials; ++trial) {  // One warm-up
+		vector<vector<T>> copies(batch, input);
+		const auto begin = chrono::steady_clock::now();
+		// Time this piece of code.
+		for (vector<T> &copy : copies)
+			sort(copy);
+		// End of piece of code to time.
+		const auto end = chrono::steady_clock::now();
+		if (trial >= 0)
+			times.push_back((double) chrono::duration_cast<chrono::nanoseconds>(end - begin).count() / batch);
+	}
+	std::sort(times.begin(), times.end());
+	return times[times.size() / 2];
+}
+
+/**
+ * Measures the size buckets of the element type T (named @type_name)
+ * sorted with Compare, and records the best cutoff and algorithm of each
+ * in the profile of this process.
+ */
+template <typename T, typename Compare>
+void TuneOrder(const string &type_name, const string &order, const Options &options) {
+	const int type = TuningType<T>::index;
+	const bool descending = StandardOrder<Compare>::descending;
+	const vector<function<void(vector<T> &)>> algorithms = {
+		[](vector<T> &a) { quicksort(a, Compare{}); },
+		[](vector<T> &a) { mergeSort(a, Compare{}); },
+		[](vector<T> &a) { heapsort(a, Compare{}); },
+		[](vector<T> &a) { SORT(a, Compare{}); },
+		[](vector<T> &a) { timSort(a, Compare{}); },
+	};
+
+	mt19937_64 rng(options.seed);
+	for (int bucket = 4; 3LL << (bucket - 1) <= options.max_size; bucket += 2) {
+		const long long size = 3LL << (bucket - 1);  // The middle of the bucket
+		vector<T> input;
+		for (long long i = 0; i < size; ++i)
+			input.push_back(MakeItem<T>(rng()));
+
+		TuningEntry best{TUNED_QUICKSORT, INSERTION_SORT_CUTOFF};
+		double best_ns = 0;
+		vector<int> measured;
+		for (int candidate : CUTOFFS) {
+			// The leaf may cap the cutoff (networks sort at most networkLeafSize items)
+			sortTuningProfile().set(type, descending, bucket, TuningEntry{TUNED_QUICKSORT, candidate});
+			const int cutoff = SortLeaf<T *, Compare>::cutoff(size);
+			if (find(measured.begin(), measured.end(), cutoff) != measured.end())
+				continue;
+			measured.push_back(cutoff);
+			sortTuningProfile().set(type, descending, bucket, TuningEntry{TUNED_QUICKSORT, cutoff});
+			const double ns = MedianTime(input, algorithms[TUNED_QUICKSORT], options.trials);
+			if (best_ns == 0 || ns < best_ns) {
+				best_ns = ns;
+				best.cutoff = cutoff;
+			}
+		}
+
+		sortTuningProfile().set(type, descending, bucket, best);
+		for (int algorithm = 0; algorithm < TUNED_ALGORITHM_COUNT; ++algorithm) {
+			const double ns = algorithm == TUNED_QUICKSORT ? best_ns
+				: MedianTime(input, algorithms[algorithm], options.trials);
+			if (ns < best_ns) {
+				best_ns = ns;
+				best.algorithm = algorithm;
+			}
+		}
+		sortTuningProfile().set(type, descending, bucket, best);
+
+		char line[256];
+		snprintf(line, sizeof(line), "%-7s %-8s %9lld  cutoff %3d  %-10s %12.0fns", type_name.c_str(),
+		         order.c_str(), size, best.cutoff, tunedAlgorithmName(best.algorithm), best_ns);
+		cout << line << endl;
+	}
+}
+
+template <typename T>
+void TuneType(const string &type_name, const Options &options) {
+	TuneOrder<T, less<T>>(type_name, "less", options);
+	TuneOrder<T, greater<T>>(type_name, "greater", options);
+}
+
+// Splits the comma-separated list @text.
+vector<string> SplitList(const string &text) {
+	vector<string> items;
+	stringstream stream(text);
+	string item;
+	while (getline(stream, item, ','))
+		if (!item.empty())
+			items.push_back(item);
+	return items;
+}
+
+// Parses the command line into @options; returns false (after printing why) on an error.
+bool ParseOptions(int argc, char **argv, Options &options) {
+	for (int i = 1; i < argc; i += 2) {
+		const string name = argv[i];
+		if (i + 1 >= argc) {
+			cout << "Missing value for " << name << endl;
+			return false;
+		}
+		const string value = argv[i + 1];
+		if (name == "--output") {
+			options.output = value;
+		} else if (name == "--types") {
+			options.types = SplitList(value);
+		} else if (name == "--max_size") {
+			options.max_size = stoll(value);
+		} else if (name == "--trials") {
+			options.trials = stoi(value);
+		} else if (name == "--seed") {
+			options.seed = stoull(value);
+		} else {
+			cout << "Unknown option " << name << endl;
+			return false;
+		}
+	}
+
+	for (const string &type : options.types)
+		if (find(ALL_TYPES.begin(), ALL_TYPES.end(), type) == ALL_TYPES.end()) {
+			cout << "Invalid type " << type << endl;
+			return false;
+		}
+	if (options.max_size < 24 || options.max_size > INT32_MAX) {
+		cout << "Invalid maximum size (24 to 2^31 - 1)" << endl;
+		return false;
+	}
+	if (options.trials < 1) {
+		cout << "Invalid number of trials" << endl;
+		return false;
+	}
+	return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+	Options options;
+	if (!ParseOptions(argc, argv, options)) {
+		cout << "Usage: " << argv[0] << " [--output sort_tuning.profile] [--types int32,int64,double,string]"
+		     << " [--max_size 262144] [--trials 5] [--seed 1]" << endl;
+		return 0;
+	}
+
+	sortTuningProfile().clear();  // Measure the built-in defaults, not an older profile
+	for (const string &type : options.types) {
+		if (type == "int32")
+			TuneType<int32_t>(type, options);
+		else if (type == "int64")
+			TuneType<int64_t>(type, options);
+		else if (type == "double")
+			TuneType<double>(type, options);
+		else
+			TuneType<string>(type, options);
+	}
+
+	if (!sortTuningProfile().save(options.output)) {
+		cout << "Cannot write " << options.output << endl;
+		return 1;
+	}
+	cout << "Profile written to " << options.output << endl;
+	return 0;
+}